@@ -0,0 +1,75 @@
+// Invoking a set of callbacks back to back: a plain vector of
+// unique_function, which makes one indirect call per element through
+// whichever vtable it holds, against unique_function_batch, which groups
+// the targets by type and loops over each group with a single target.
+// "Homogeneous" holds one callback type; "mixed" interleaves four.
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "function_unique.h"
+#include "function_unique_batch.h"
+
+namespace
+{
+  template<int N>
+    struct subscriber
+    {
+      void operator()(long& total) const { total += N * value; }
+      long value = 1;
+    };
+
+  using callback = std::unique_function<void(long&)>;
+
+  struct plain_vector
+  {
+    void insert(callback&& f) { callbacks.push_back(std::move(f)); }
+
+    void
+    invoke_all(long& total)
+    {
+      for (auto& f : callbacks)
+	f(total);
+    }
+
+    std::vector<callback> callbacks;
+  };
+
+  using batch = std::unique_function_batch<void(long&)>;
+
+  template<typename Container>
+    void
+    fill(Container& c, long n, bool mixed)
+    {
+      for (long i = 0; i < n; ++i)
+	switch (mixed ? i % 4 : 0)
+	  {
+	  case 0: c.insert(subscriber<1>()); break;
+	  case 1: c.insert(subscriber<2>()); break;
+	  case 2: c.insert(subscriber<3>()); break;
+	  case 3: c.insert(subscriber<4>()); break;
+	  }
+    }
+
+  template<typename Container, bool Mixed>
+    void
+    invoke_all(benchmark::State& state)
+    {
+      Container c;
+      fill(c, state.range(0), Mixed);
+      long total = 0;
+      for (auto _ : state)
+	{
+	  c.invoke_all(total);
+	  benchmark::ClobberMemory();
+	}
+      benchmark::DoNotOptimize(total);
+      state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+}
+
+BENCHMARK_TEMPLATE(invoke_all, plain_vector, false)->Arg(1 << 12);
+BENCHMARK_TEMPLATE(invoke_all, batch, false)->Arg(1 << 12);
+BENCHMARK_TEMPLATE(invoke_all, plain_vector, true)->Arg(1 << 12);
+BENCHMARK_TEMPLATE(invoke_all, batch, true)->Arg(1 << 12);
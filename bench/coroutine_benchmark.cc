@@ -0,0 +1,119 @@
+// One await of a callback-based read from a coroutine.  The usual
+// adapter shares a result block with the callback and captures the
+// coroutine handle next to it, so each await allocates the block and,
+// since that closure does not fit the local buffer, the callback too.
+// await_unique_function keeps the results in the awaiter and passes a
+// callback that holds one pointer.  The read completes later, from the
+// benchmark loop, as it would from an event loop.
+
+#include <benchmark/benchmark.h>
+
+#include <coroutine>
+#include <memory>
+#include <new>
+#include <system_error>
+
+#include "counting_allocator.h"
+#include "function_unique.h"
+#include "function_unique_coroutine.h"
+
+namespace
+{
+  using read_callback
+    = std::unique_function<void(std::error_code, std::size_t)>;
+
+  // A socket whose reads complete when the event loop says so.
+  struct socket
+  {
+    void
+    async_read(read_callback cb)
+    { pending = std::move(cb); }
+
+    void
+    complete(std::size_t n)
+    { std::move(pending)(std::error_code(), n); }
+
+    read_callback pending;
+  };
+
+  struct detached
+  {
+    struct promise_type
+    {
+      detached get_return_object() { return {}; }
+      std::suspend_never initial_suspend() noexcept { return {}; }
+      std::suspend_never final_suspend() noexcept { return {}; }
+      void return_void() { }
+      void unhandled_exception() { std::terminate(); }
+    };
+  };
+
+  struct read_result
+  {
+    std::error_code ec;
+    std::size_t n = 0;
+  };
+
+  struct shared_read
+  {
+    bool await_ready() const noexcept { return false; }
+
+    void
+    await_suspend(std::coroutine_handle<> h)
+    {
+      result = std::make_shared<read_result>();
+      s.async_read([h, r = result](std::error_code ec, std::size_t n) {
+	r->ec = ec;
+	r->n = n;
+	h.resume();
+      });
+    }
+
+    read_result await_resume() { return *result; }
+
+    socket& s;
+    std::shared_ptr<read_result> result;
+  };
+
+  detached
+  read_loop_shared(socket& s, std::size_t& total, const bool& stop)
+  {
+    while (!stop)
+      total += (co_await shared_read{s, nullptr}).n;
+  }
+
+  detached
+  read_loop_awaiter(socket& s, std::size_t& total, const bool& stop)
+  {
+    while (!stop)
+      {
+	auto [ec, n]
+	  = co_await std::await_unique_function<void(std::error_code,
+						     std::size_t)>(
+	      [&s](read_callback cb) { s.async_read(std::move(cb)); });
+	total += n;
+      }
+  }
+
+  template<detached (*Loop)(socket&, std::size_t&, const bool&)>
+    void
+    await_read(benchmark::State& state)
+    {
+      socket s;
+      std::size_t total = 0;
+      bool stop = false;
+      Loop(s, total, stop);
+      const std::size_t before = counting_allocator::allocations();
+      for (auto _ : state)
+	s.complete(1);
+      state.counters["allocs/op"]
+	= double(counting_allocator::allocations() - before)
+	  / state.iterations();
+      stop = true;
+      s.complete(1);
+      benchmark::DoNotOptimize(total);
+    }
+}
+
+BENCHMARK_TEMPLATE(await_read, read_loop_shared);
+BENCHMARK_TEMPLATE(await_read, read_loop_awaiter);
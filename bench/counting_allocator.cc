@@ -0,0 +1,118 @@
+// Every replaceable form of the global operator new and delete, built on
+// malloc and free.  They live in their own translation unit so that the
+// compiler never sees a new expression paired with free.
+
+#include "counting_allocator.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+  std::size_t count = 0;
+
+  void*
+  allocate(std::size_t n, std::size_t align)
+  {
+    ++count;
+    if (n == 0)
+      n = 1;
+    void* p = align <= alignof(std::max_align_t)
+      ? std::malloc(n)
+      : std::aligned_alloc(align, (n + align - 1) / align * align);
+    return p;
+  }
+
+  void*
+  allocate_or_throw(std::size_t n, std::size_t align)
+  {
+    if (void* p = allocate(n, align))
+      return p;
+    throw std::bad_alloc();
+  }
+}
+
+std::size_t
+counting_allocator::allocations() noexcept
+{ return count; }
+
+void*
+operator new(std::size_t n)
+{ return allocate_or_throw(n, 1); }
+
+void*
+operator new[](std::size_t n)
+{ return allocate_or_throw(n, 1); }
+
+void*
+operator new(std::size_t n, const std::nothrow_t&) noexcept
+{ return allocate(n, 1); }
+
+void*
+operator new[](std::size_t n, const std::nothrow_t&) noexcept
+{ return allocate(n, 1); }
+
+void*
+operator new(std::size_t n, std::align_val_t a)
+{ return allocate_or_throw(n, std::size_t(a)); }
+
+void*
+operator new[](std::size_t n, std::align_val_t a)
+{ return allocate_or_throw(n, std::size_t(a)); }
+
+void*
+operator new(std::size_t n, std::align_val_t a, const std::nothrow_t&) noexcept
+{ return allocate(n, std::size_t(a)); }
+
+void*
+operator new[](std::size_t n, std::align_val_t a,
+	       const std::nothrow_t&) noexcept
+{ return allocate(n, std::size_t(a)); }
+
+void
+operator delete(void* p) noexcept
+{ std::free(p); }
+
+void
+operator delete[](void* p) noexcept
+{ std::free(p); }
+
+void
+operator delete(void* p, std::size_t) noexcept
+{ std::free(p); }
+
+void
+operator delete[](void* p, std::size_t) noexcept
+{ std::free(p); }
+
+void
+operator delete(void* p, const std::nothrow_t&) noexcept
+{ std::free(p); }
+
+void
+operator delete[](void* p, const std::nothrow_t&) noexcept
+{ std::free(p); }
+
+void
+operator delete(void* p, std::align_val_t) noexcept
+{ std::free(p); }
+
+void
+operator delete[](void* p, std::align_val_t) noexcept
+{ std::free(p); }
+
+void
+operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{ std::free(p); }
+
+void
+operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+{ std::free(p); }
+
+void
+operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{ std::free(p); }
+
+void
+operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{ std::free(p); }
@@ -0,0 +1,18 @@
+// Replacements for every form of the global operator new and delete
+// that count allocations, for benchmarks reporting allocations per
+// operation.  Link counting_allocator.cc to use them.  The count is not
+// synchronized, so only single-threaded benchmarks link it.
+
+#ifndef COUNTING_ALLOCATOR_H_
+#define COUNTING_ALLOCATOR_H_
+
+#include <cstddef>
+
+namespace counting_allocator
+{
+  // The number of calls to any operator new so far.
+  std::size_t
+  allocations() noexcept;
+}
+
+#endif /* COUNTING_ALLOCATOR_H_ */
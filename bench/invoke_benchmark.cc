@@ -0,0 +1,125 @@
+// Tight-loop call cost: std::function tests for a target on every call,
+// unique_function::operator() makes one unconditional indirect call
+// through its vtable, and invoke_unchecked() skips even the empty-state
+// vtable by contract.  pass_callback measures handing a 32-byte closure
+// to a function that calls it once, through an owning wrapper or
+// through unique_function_ref.  call_function and move_function hold a
+// free function, which unique_function calls through its invoker and
+// relocates without a vtable call, and compare against a raw function
+// pointer.
+
+#include <benchmark/benchmark.h>
+
+#include <functional>
+
+#include "function_unique.h"
+
+namespace
+{
+  constexpr benchmark::IterationCount calls = 1 << 28;
+
+  struct increment
+  {
+    int operator()(int x) const { return x + 1; }
+  };
+
+  template<typename Wrapper>
+    void
+    call_operator(benchmark::State& state)
+    {
+      Wrapper f = increment();
+      int x = 0;
+      for (auto _ : state)
+	{
+	  benchmark::DoNotOptimize(f);
+	  x = f(x);
+	}
+      benchmark::DoNotOptimize(x);
+    }
+
+  void
+  invoke_unchecked(benchmark::State& state)
+  {
+    std::unique_function<int(int)> f = increment();
+    int x = 0;
+    for (auto _ : state)
+      {
+	benchmark::DoNotOptimize(f);
+	x = f.invoke_unchecked(x);
+      }
+    benchmark::DoNotOptimize(x);
+  }
+
+  [[gnu::noinline]] int
+  add_one(int x)
+  { return x + 1; }
+
+  template<typename Wrapper>
+    void
+    call_function(benchmark::State& state)
+    {
+      Wrapper f = &add_one;
+      int x = 0;
+      for (auto _ : state)
+	{
+	  benchmark::DoNotOptimize(f);
+	  x = f(x);
+	}
+      benchmark::DoNotOptimize(x);
+    }
+
+  // Constructs a wrapper holding a free function, moves it once and
+  // destroys both wrappers.
+  template<typename Wrapper>
+    void
+    move_function(benchmark::State& state)
+    {
+      for (auto _ : state)
+	{
+	  Wrapper f = &add_one;
+	  benchmark::DoNotOptimize(f);
+	  Wrapper g = std::move(f);
+	  benchmark::DoNotOptimize(g);
+	}
+    }
+
+  struct accumulate
+  {
+    int operator()(int x) { return x + a + b + c + d; }
+    long a = 1, b = 1, c = 1, d = 1;
+  };
+
+  template<typename Callback>
+    [[gnu::noinline]] int
+    visit(Callback f, int x)
+    { return f(x); }
+
+  template<typename Callback>
+    void
+    pass_callback(benchmark::State& state)
+    {
+      accumulate acc;
+      int x = 0;
+      for (auto _ : state)
+	{
+	  benchmark::DoNotOptimize(acc);
+	  x = visit<Callback>(acc, x);
+	}
+      benchmark::DoNotOptimize(x);
+    }
+}
+
+BENCHMARK_TEMPLATE(call_operator, std::function<int(int)>)
+  ->Iterations(calls);
+BENCHMARK_TEMPLATE(call_operator, std::unique_function<int(int)>)
+  ->Iterations(calls);
+BENCHMARK(invoke_unchecked)->Iterations(calls);
+BENCHMARK_TEMPLATE(call_function, int (*)(int))->Iterations(calls);
+BENCHMARK_TEMPLATE(call_function, std::function<int(int)>)
+  ->Iterations(calls);
+BENCHMARK_TEMPLATE(call_function, std::unique_function<int(int)>)
+  ->Iterations(calls);
+BENCHMARK_TEMPLATE(move_function, int (*)(int));
+BENCHMARK_TEMPLATE(move_function, std::unique_function<int(int)>);
+BENCHMARK_TEMPLATE(pass_callback, std::unique_function<int(int)>);
+BENCHMARK_TEMPLATE(pass_callback, std::unique_function_ref<int(int)>);
@@ -0,0 +1,135 @@
+// Size and call latency of unique_function, which keeps a single pointer
+// to a per-target vtable, against std::function, which keeps separate
+// invoker and manager pointers next to the same 16-byte buffer.  Also
+// a set of three handlers implemented by one object, held either as
+// three unique_function objects sharing the object or as one
+// unique_multi_function.
+
+#include <benchmark/benchmark.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "function_unique.h"
+#include "function_unique_multi.h"
+
+namespace
+{
+  // Fits in the 16-byte local buffer of both wrappers.
+  struct small_functor
+  {
+    int operator()(int x) const { return x + value; }
+    int value = 1;
+  };
+
+  // Too large for either local buffer, so the target lives on the heap.
+  struct large_functor
+  {
+    int operator()(int x) const { return x + value[7]; }
+    int value[8] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+  };
+
+  template<typename Wrapper, typename Functor>
+    void
+    invoke(benchmark::State& state)
+    {
+      Wrapper f = Functor();
+      int x = 0;
+      for (auto _ : state)
+	{
+	  // Hide the target from the optimizer so every call is indirect.
+	  benchmark::DoNotOptimize(f);
+	  x = f(x);
+	}
+      benchmark::DoNotOptimize(x);
+      state.counters["sizeof"] = sizeof(Wrapper);
+    }
+
+  // Walks a large array of wrappers, where the footprint of each wrapper
+  // decides how many fit in a cache line.
+  template<typename Wrapper>
+    void
+    invoke_array(benchmark::State& state)
+    {
+      std::vector<Wrapper> fs(state.range(0));
+      for (auto& f : fs)
+	f = small_functor();
+      int x = 0;
+      for (auto _ : state)
+	for (auto& f : fs)
+	  x = f(x);
+      benchmark::DoNotOptimize(x);
+      state.SetItemsProcessed(state.iterations() * fs.size());
+      state.counters["sizeof"] = sizeof(Wrapper);
+    }
+
+  // The data, error and close handlers of a connection.
+  struct connection_handlers
+  {
+    void operator()(int bytes) { received += bytes; }
+    void operator()(const std::string& error) { errors += error.size(); }
+    void operator()() { ++closed; }
+    long received = 0, errors = 0, closed = 0;
+  };
+
+  struct separate_handlers
+  {
+    explicit
+    separate_handlers(std::shared_ptr<connection_handlers> h)
+    : on_data([h](int bytes) { (*h)(bytes); }),
+      on_error([h](const std::string& error) { (*h)(error); }),
+      on_close([h] { (*h)(); })
+    { }
+
+    std::unique_function<void(int)> on_data;
+    std::unique_function<void(const std::string&)> on_error;
+    std::unique_function<void()> on_close;
+  };
+
+  using multi_handlers
+    = std::unique_multi_function<void(int), void(const std::string&),
+				 void()>;
+
+  void
+  handlers_separate(benchmark::State& state)
+  {
+    const std::string error = "reset";
+    for (auto _ : state)
+      {
+	separate_handlers h(std::make_shared<connection_handlers>());
+	h.on_data(1);
+	h.on_error(error);
+	h.on_close();
+	benchmark::DoNotOptimize(h);
+      }
+    state.counters["sizeof"] = sizeof(separate_handlers);
+  }
+
+  void
+  handlers_multi(benchmark::State& state)
+  {
+    const std::string error = "reset";
+    for (auto _ : state)
+      {
+	multi_handlers h = connection_handlers();
+	h(1);
+	h(error);
+	h();
+	benchmark::DoNotOptimize(h);
+      }
+    state.counters["sizeof"] = sizeof(multi_handlers);
+  }
+}
+
+BENCHMARK_TEMPLATE(invoke, std::function<int(int)>, small_functor);
+BENCHMARK_TEMPLATE(invoke, std::unique_function<int(int)>, small_functor);
+BENCHMARK_TEMPLATE(invoke, std::function<int(int)>, large_functor);
+BENCHMARK_TEMPLATE(invoke, std::unique_function<int(int)>, large_functor);
+BENCHMARK_TEMPLATE(invoke_array, std::function<int(int)>)
+  ->Arg(1 << 10)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(invoke_array, std::unique_function<int(int)>)
+  ->Arg(1 << 10)->Arg(1 << 20);
+BENCHMARK(handlers_separate);
+BENCHMARK(handlers_multi);
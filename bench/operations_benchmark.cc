@@ -0,0 +1,281 @@
+// Cost of each wrapper operation for targets from empty to 256 bytes:
+// construct, destroy, move, swap, invoke and growing a vector.
+// unique_function is compared against std::function and, where it makes
+// sense, a raw function pointer.  Move-only targets cannot be stored in
+// std::function at all, so only the unique_function wrappers run them.
+// Every benchmark reports heap allocations per operation next to ns/op.
+
+#include <benchmark/benchmark.h>
+
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "counting_allocator.h"
+#include "function_unique.h"
+#include "function_unique_vector.h"
+
+namespace
+{
+  // A trivially copyable target of exactly N bytes.
+  template<std::size_t N>
+    struct payload
+    {
+      int operator()(int x) const { return x + data[0]; }
+      unsigned char data[N] = { 1 };
+    };
+
+  // A captureless target.
+  template<>
+    struct payload<0>
+    {
+      int operator()(int x) const { return x + 1; }
+    };
+
+  // A target of N bytes, or of one pointer if N is smaller, that owns a
+  // unique_ptr, as a closure capturing one does.  It is move-only and
+  // neither trivially copyable nor trivially destructible, so moving and
+  // destroying it go through the vtable.  The pointer stays null, so the
+  // target allocates nothing itself.
+  template<std::size_t N,
+	   bool = (N > sizeof(std::unique_ptr<int>))>
+    struct move_only
+    {
+      int operator()(int x) const { return x + data[0]; }
+      std::unique_ptr<int> owner;
+      unsigned char data[N - sizeof(std::unique_ptr<int>)] = { 1 };
+    };
+
+  template<std::size_t N>
+    struct move_only<N, false>
+    {
+      int operator()(int x) const { return x + 1; }
+      std::unique_ptr<int> owner;
+    };
+
+  static_assert(!std::is_trivially_copyable<move_only<8>>::value
+		&& sizeof(move_only<64>) == 64,
+		"move_only targets must not be relocatable bytewise");
+
+  int
+  increment(int x)
+  { return x + 1; }
+
+  using function = std::function<int(int)>;
+  using unique = std::unique_function<int(int)>;
+  using unique64 = std::basic_unique_function<int(int), 64>;
+
+  constexpr std::size_t batch = 1024;
+
+  // Record allocations per operation for the state's whole run.
+  class allocation_counter
+  {
+  public:
+    explicit
+    allocation_counter(benchmark::State& state)
+    : state(state), start(counting_allocator::allocations()) { }
+
+    ~allocation_counter()
+    {
+      const double ops = state.items_processed() ? state.items_processed()
+						 : state.iterations();
+      state.counters["allocs/op"]
+	= double(counting_allocator::allocations() - start) / ops;
+    }
+
+  private:
+    benchmark::State& state;
+    std::size_t start;
+  };
+
+  // Wrappers constructed and destroyed by hand, so that either step can
+  // be timed on its own.
+  template<typename Wrapper>
+    struct raw_array
+    {
+      Wrapper* get() { return reinterpret_cast<Wrapper*>(storage); }
+
+      template<typename Functor>
+	void
+	construct()
+	{
+	  for (std::size_t i = 0; i < batch; ++i)
+	    ::new (static_cast<void*>(get() + i)) Wrapper(Functor());
+	}
+
+      void
+      destroy()
+      {
+	for (std::size_t i = 0; i < batch; ++i)
+	  get()[i].~Wrapper();
+      }
+
+      alignas(Wrapper) unsigned char storage[batch * sizeof(Wrapper)];
+    };
+
+  template<typename Wrapper, typename Functor>
+    void
+    construct(benchmark::State& state)
+    {
+      auto array = new raw_array<Wrapper>;
+      allocation_counter counter(state);
+      for (auto _ : state)
+	{
+	  array->template construct<Functor>();
+	  benchmark::ClobberMemory();
+	  state.PauseTiming();
+	  array->destroy();
+	  state.ResumeTiming();
+	}
+      state.SetItemsProcessed(state.iterations() * batch);
+      delete array;
+    }
+
+  template<typename Wrapper, typename Functor>
+    void
+    destroy(benchmark::State& state)
+    {
+      auto array = new raw_array<Wrapper>;
+      allocation_counter counter(state);
+      for (auto _ : state)
+	{
+	  state.PauseTiming();
+	  array->template construct<Functor>();
+	  state.ResumeTiming();
+	  array->destroy();
+	  benchmark::ClobberMemory();
+	}
+      state.SetItemsProcessed(state.iterations() * batch);
+      delete array;
+    }
+
+  // One move construction and one move assignment per iteration.
+  template<typename Wrapper, typename Functor>
+    void
+    move(benchmark::State& state)
+    {
+      Wrapper f = Functor();
+      allocation_counter counter(state);
+      for (auto _ : state)
+	{
+	  Wrapper g(std::move(f));
+	  benchmark::DoNotOptimize(g);
+	  f = std::move(g);
+	  benchmark::DoNotOptimize(f);
+	}
+      state.SetItemsProcessed(state.iterations() * 2);
+    }
+
+  template<typename Wrapper, typename Functor>
+    void
+    swap(benchmark::State& state)
+    {
+      Wrapper f = Functor();
+      Wrapper g = Functor();
+      allocation_counter counter(state);
+      for (auto _ : state)
+	{
+	  f.swap(g);
+	  benchmark::DoNotOptimize(f);
+	  benchmark::DoNotOptimize(g);
+	}
+    }
+
+  template<typename Wrapper, typename Functor>
+    void
+    invoke(benchmark::State& state)
+    {
+      Wrapper f = Functor();
+      int x = 0;
+      allocation_counter counter(state);
+      for (auto _ : state)
+	{
+	  benchmark::DoNotOptimize(f);
+	  x = f(x);
+	}
+      benchmark::DoNotOptimize(x);
+    }
+
+  void
+  invoke_raw_pointer(benchmark::State& state)
+  {
+    int (*f)(int) = &increment;
+    int x = 0;
+    allocation_counter counter(state);
+    for (auto _ : state)
+      {
+	benchmark::DoNotOptimize(f);
+	x = f(x);
+      }
+    benchmark::DoNotOptimize(x);
+  }
+
+  // Appends a batch of targets to an empty vector, which has to grow
+  // several times on the way.
+  template<typename Vector, typename Functor>
+    void
+    push_back(benchmark::State& state)
+    {
+      allocation_counter counter(state);
+      for (auto _ : state)
+	{
+	  Vector v;
+	  for (std::size_t i = 0; i < batch; ++i)
+	    v.push_back(Functor());
+	  benchmark::DoNotOptimize(v.data());
+	}
+      state.SetItemsProcessed(state.iterations() * batch);
+    }
+
+  // Grows a vector of targets one element at a time with resize, which
+  // relocates the targets already present on every reallocation.
+  template<typename Vector, typename Functor>
+    void
+    resize(benchmark::State& state)
+    {
+      allocation_counter counter(state);
+      for (auto _ : state)
+	{
+	  Vector v;
+	  for (std::size_t i = 0; i < batch; ++i)
+	    {
+	      v.resize(i + 1);
+	      v[i] = Functor();
+	    }
+	  benchmark::DoNotOptimize(v.data());
+	}
+      state.SetItemsProcessed(state.iterations() * batch);
+    }
+
+  using function_vector = std::vector<function>;
+  using unique_vector = std::vector<unique>;
+  using unique_function_vector = std::unique_function_vector<int(int)>;
+}
+
+#define BENCHMARK_SIZES(op, Wrapper, Functor)				\
+  BENCHMARK_TEMPLATE(op, Wrapper, Functor<0>);				\
+  BENCHMARK_TEMPLATE(op, Wrapper, Functor<8>);				\
+  BENCHMARK_TEMPLATE(op, Wrapper, Functor<16>);				\
+  BENCHMARK_TEMPLATE(op, Wrapper, Functor<32>);				\
+  BENCHMARK_TEMPLATE(op, Wrapper, Functor<64>);				\
+  BENCHMARK_TEMPLATE(op, Wrapper, Functor<256>)
+
+#define BENCHMARK_WRAPPERS(op, Function, Unique, Unique64)		\
+  BENCHMARK_SIZES(op, Function, payload);				\
+  BENCHMARK_SIZES(op, Unique, payload);					\
+  BENCHMARK_SIZES(op, Unique64, payload);				\
+  BENCHMARK_SIZES(op, Unique, move_only);				\
+  BENCHMARK_SIZES(op, Unique64, move_only)
+
+BENCHMARK_WRAPPERS(construct, function, unique, unique64);
+BENCHMARK_WRAPPERS(destroy, function, unique, unique64);
+BENCHMARK_WRAPPERS(move, function, unique, unique64);
+BENCHMARK_WRAPPERS(swap, function, unique, unique64);
+BENCHMARK(invoke_raw_pointer);
+BENCHMARK_WRAPPERS(invoke, function, unique, unique64);
+BENCHMARK_WRAPPERS(push_back, function_vector, unique_vector,
+		   unique_function_vector);
+BENCHMARK_WRAPPERS(resize, function_vector, unique_vector,
+		   unique_function_vector);
@@ -0,0 +1,69 @@
+// Construct/destroy cost of targets too large for the local buffer,
+// allocated with operator new or with unique_function_pool_allocator.
+// The cross-thread case creates closures on a producer thread and
+// destroys them on the consumer, as a task queue does.
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <thread>
+
+#include "function_unique.h"
+#include "function_unique_pool.h"
+#include "function_unique_queue.h"
+
+namespace
+{
+  struct request
+  {
+    int operator()() const { return context[0]; }
+    char context[200] = { 1 };
+  };
+
+  using task = std::unique_function<int()>;
+
+  template<typename Alloc>
+    void
+    same_thread(benchmark::State& state)
+    {
+      Alloc alloc;
+      for (auto _ : state)
+	{
+	  task f(std::allocator_arg, alloc, request());
+	  benchmark::DoNotOptimize(f);
+	}
+    }
+
+  template<typename Alloc>
+    void
+    cross_thread(benchmark::State& state)
+    {
+      constexpr long tasks = 1 << 16;
+      Alloc alloc;
+      for (auto _ : state)
+	{
+	  std::unique_function_queue<int()> queue(1 << 10);
+	  std::thread producer([&queue, &alloc] {
+	    for (long i = 0; i < tasks; ++i)
+	      {
+		task f(std::allocator_arg, alloc, request());
+		while (!queue.try_push(std::move(f)))
+		  std::this_thread::yield();
+	      }
+	  });
+	  for (long done = 0; done < tasks; )
+	    if (queue.try_invoke())
+	      ++done;
+	    else
+	      std::this_thread::yield();
+	  producer.join();
+	}
+      state.SetItemsProcessed(state.iterations() * tasks);
+    }
+}
+
+BENCHMARK_TEMPLATE(same_thread, std::allocator<char>);
+BENCHMARK_TEMPLATE(same_thread, std::unique_function_pool_allocator<char>);
+BENCHMARK_TEMPLATE(cross_thread, std::allocator<char>)->UseRealTime();
+BENCHMARK_TEMPLATE(cross_thread, std::unique_function_pool_allocator<char>)
+  ->UseRealTime();
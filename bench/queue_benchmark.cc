@@ -0,0 +1,96 @@
+// Throughput of shipping closures from 1 to N producer threads to one
+// consumer: unique_function_queue, which constructs each wrapper in its
+// ring buffer slot, against a mutex-protected std::deque of
+// unique_function, which moves every wrapper in and out of the deque.
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "function_unique.h"
+#include "function_unique_queue.h"
+
+namespace
+{
+  constexpr std::size_t tasks_per_producer = 1 << 16;
+
+  using task = std::unique_function<void()>;
+
+  // The lock-based queue every team writes by hand.
+  class locked_queue
+  {
+  public:
+    template<typename Functor>
+      bool
+      try_push(Functor&& f)
+      {
+	std::lock_guard<std::mutex> lock(mutex);
+	tasks.emplace_back(std::forward<Functor>(f));
+	return true;
+      }
+
+    bool
+    try_invoke()
+    {
+      task t;
+      {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (tasks.empty())
+	  return false;
+	t = std::move(tasks.front());
+	tasks.pop_front();
+      }
+      t();
+      return true;
+    }
+
+  private:
+    std::mutex mutex;
+    std::deque<task> tasks;
+  };
+
+  struct lock_free_queue : std::unique_function_queue<void()>
+  {
+    lock_free_queue() : std::unique_function_queue<void()>(1 << 12) { }
+  };
+
+  template<typename Queue>
+    void
+    producers(benchmark::State& state)
+    {
+      const int n = state.range(0);
+      for (auto _ : state)
+	{
+	  Queue queue;
+	  std::size_t sum = 0;
+	  std::vector<std::thread> threads;
+	  for (int p = 0; p < n; ++p)
+	    threads.emplace_back([&queue, &sum] {
+	      for (std::size_t i = 0; i < tasks_per_producer; ++i)
+		// Captures two pointers, so it fits the local buffer.
+		while (!queue.try_push([&sum, i] { sum += i; }))
+		  std::this_thread::yield();
+	    });
+
+	  for (std::size_t done = 0; done < n * tasks_per_producer; )
+	    if (queue.try_invoke())
+	      ++done;
+	    else
+	      std::this_thread::yield();
+
+	  for (auto& t : threads)
+	    t.join();
+	  benchmark::DoNotOptimize(sum);
+	}
+      state.SetItemsProcessed(state.iterations() * n * tasks_per_producer);
+    }
+}
+
+BENCHMARK_TEMPLATE(producers, locked_queue)
+  ->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(producers, lock_free_queue)
+  ->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
@@ -0,0 +1,65 @@
+// Time spent on the releasing thread when a wrapper whose closure owns
+// many heap blocks goes away: destroyed in place, or handed to
+// unique_function_reclaimer, whose background thread runs the destructor.
+// The CPU column is the releasing thread's own time; wall time also
+// counts the reclaimer thread whenever the two share a core.
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "function_unique.h"
+#include "function_unique_reclaimer.h"
+
+namespace
+{
+  using callback = std::unique_function<void()>;
+
+  constexpr std::size_t batch = 256;
+
+  // A completion handler that captured a response of 64 strings.
+  callback
+  make_handler()
+  {
+    std::vector<std::string> response(64, std::string(64, 'x'));
+    return [response = std::move(response)] {
+      benchmark::DoNotOptimize(response.data());
+    };
+  }
+
+  template<typename Release>
+    void
+    release_batches(benchmark::State& state, Release release)
+    {
+      std::vector<callback> handlers(batch);
+      for (auto _ : state)
+	{
+	  state.PauseTiming();
+	  for (auto& h : handlers)
+	    h = make_handler();
+	  state.ResumeTiming();
+	  for (auto& h : handlers)
+	    release(h);
+	}
+      state.SetItemsProcessed(state.iterations() * batch);
+    }
+
+  void
+  destroy_inline(benchmark::State& state)
+  {
+    release_batches(state, [](callback& h) { h = nullptr; });
+  }
+
+  void
+  defer_destroy(benchmark::State& state)
+  {
+    std::unique_function_reclaimer<> reclaimer(4 * batch);
+    release_batches(state, [&](callback& h) {
+      reclaimer.defer_destroy(std::move(h));
+    });
+  }
+}
+
+BENCHMARK(destroy_inline);
+BENCHMARK(defer_destroy);
@@ -0,0 +1,91 @@
+// Dispatching 10^8 messages over 1000 handlers in a random order:
+// unordered_map<int, unique_function> against unique_function_table,
+// which replaces the hash lookup with an index and a generation compare
+// and packs the out-of-line targets into one slab.  Handlers capture
+// either 8 bytes, which fit the local buffer, or 48, which do not.
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "function_unique.h"
+#include "function_unique_table.h"
+
+namespace
+{
+  struct message
+  {
+    int id;
+    long sum;
+  };
+
+  using handler = std::unique_function<void(message&)>;
+
+  constexpr int handlers = 1000;
+  constexpr benchmark::IterationCount messages = 100000000;
+
+  template<std::size_t Words>
+    struct accumulate
+    {
+      void operator()(message& m) { m.sum += weight[0] + m.id; }
+      long weight[Words] = { 1 };
+    };
+
+  // A fixed random order of handler ids, cycled through.
+  std::vector<int>
+  make_order()
+  {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> id(0, handlers - 1);
+    std::vector<int> order(1 << 16);
+    for (auto& i : order)
+      i = id(gen);
+    return order;
+  }
+
+  template<std::size_t Words>
+    void
+    dispatch_map(benchmark::State& state)
+    {
+      std::unordered_map<int, handler> table;
+      for (int i = 0; i < handlers; ++i)
+	table.emplace(i, accumulate<Words>());
+      const std::vector<int> order = make_order();
+      message m{0, 0};
+      std::size_t next = 0;
+      for (auto _ : state)
+	{
+	  m.id = order[next++ & (order.size() - 1)];
+	  table.find(m.id)->second(m);
+	}
+      benchmark::DoNotOptimize(m.sum);
+      state.SetItemsProcessed(state.iterations());
+    }
+
+  template<std::size_t Words>
+    void
+    dispatch_table(benchmark::State& state)
+    {
+      std::unique_function_table<void(message&)> table;
+      std::vector<std::unique_function_table<void(message&)>::handle> ids;
+      for (int i = 0; i < handlers; ++i)
+	ids.push_back(table.insert(accumulate<Words>()));
+      const std::vector<int> order = make_order();
+      message m{0, 0};
+      std::size_t next = 0;
+      for (auto _ : state)
+	{
+	  m.id = order[next++ & (order.size() - 1)];
+	  table.invoke(ids[m.id], m);
+	}
+      benchmark::DoNotOptimize(m.sum);
+      state.SetItemsProcessed(state.iterations());
+    }
+}
+
+BENCHMARK_TEMPLATE(dispatch_map, 1)->Iterations(messages);
+BENCHMARK_TEMPLATE(dispatch_table, 1)->Iterations(messages);
+BENCHMARK_TEMPLATE(dispatch_map, 6)->Iterations(messages);
+BENCHMARK_TEMPLATE(dispatch_table, 6)->Iterations(messages);
@@ -0,0 +1,162 @@
+// unique_function_thread_pool, which keeps a Chase-Lev deque of
+// unique_function tasks per worker and steals between them, against the
+// usual pool of std::function tasks behind one mutex and condition
+// variable.  Fork/join spawns a binary tree of tasks from inside the
+// pool; fan-out submits independent tasks from outside and waits for
+// them all.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "function_unique_thread_pool.h"
+
+namespace
+{
+  class locked_pool
+  {
+  public:
+    explicit
+    locked_pool(std::size_t threads)
+    {
+      for (std::size_t i = 0; i < threads; ++i)
+	workers.emplace_back([this] { run(); });
+    }
+
+    ~locked_pool()
+    {
+      {
+	std::lock_guard<std::mutex> lock(mutex);
+	stop = true;
+      }
+      wake.notify_all();
+      for (auto& t : workers)
+	t.join();
+    }
+
+    template<typename Functor>
+      void
+      submit(Functor&& f)
+      {
+	{
+	  std::lock_guard<std::mutex> lock(mutex);
+	  tasks.emplace_back(std::forward<Functor>(f));
+	}
+	wake.notify_one();
+      }
+
+  private:
+    void
+    run()
+    {
+      for (;;)
+	{
+	  std::function<void()> task;
+	  {
+	    std::unique_lock<std::mutex> lock(mutex);
+	    wake.wait(lock, [this] { return stop || !tasks.empty(); });
+	    if (tasks.empty())
+	      return;
+	    task = std::move(tasks.front());
+	    tasks.pop_front();
+	  }
+	  task();
+	}
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> tasks;
+    std::vector<std::thread> workers;
+    bool stop = false;
+  };
+
+  using stealing_pool = std::unique_function_thread_pool<>;
+
+  // Counts finished tasks and lets the benchmark thread wait for them.
+  struct latch
+  {
+    void
+    count_down()
+    {
+      if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+	  std::lock_guard<std::mutex> lock(mutex);
+	  done.notify_all();
+	}
+    }
+
+    void
+    wait()
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      done.wait(lock, [this] {
+	return remaining.load(std::memory_order_acquire) == 0;
+      });
+    }
+
+    std::atomic<long> remaining;
+    std::mutex mutex;
+    std::condition_variable done;
+  };
+
+  template<typename Pool>
+    void
+    spawn(Pool& pool, latch& l, int depth)
+    {
+      if (depth > 0)
+	{
+	  pool.submit([&pool, &l, depth] { spawn(pool, l, depth - 1); });
+	  pool.submit([&pool, &l, depth] { spawn(pool, l, depth - 1); });
+	}
+      l.count_down();
+    }
+
+  const std::size_t threads = std::max(2u, std::thread::hardware_concurrency());
+
+  template<typename Pool>
+    void
+    fork_join(benchmark::State& state)
+    {
+      const int depth = state.range(0);
+      const long tasks = (2L << depth) - 1;
+      Pool pool(threads);
+      for (auto _ : state)
+	{
+	  latch l;
+	  l.remaining = tasks;
+	  pool.submit([&pool, &l, depth] { spawn(pool, l, depth); });
+	  l.wait();
+	}
+      state.SetItemsProcessed(state.iterations() * tasks);
+    }
+
+  template<typename Pool>
+    void
+    fan_out(benchmark::State& state)
+    {
+      const long tasks = state.range(0);
+      Pool pool(threads);
+      for (auto _ : state)
+	{
+	  latch l;
+	  l.remaining = tasks;
+	  for (long i = 0; i < tasks; ++i)
+	    pool.submit([&l] { l.count_down(); });
+	  l.wait();
+	}
+      state.SetItemsProcessed(state.iterations() * tasks);
+    }
+}
+
+BENCHMARK_TEMPLATE(fork_join, locked_pool)->Arg(12)->Arg(16)->UseRealTime();
+BENCHMARK_TEMPLATE(fork_join, stealing_pool)->Arg(12)->Arg(16)->UseRealTime();
+BENCHMARK_TEMPLATE(fan_out, locked_pool)->Arg(1 << 12)->UseRealTime();
+BENCHMARK_TEMPLATE(fan_out, stealing_pool)->Arg(1 << 12)->UseRealTime();
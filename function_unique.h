@@ -18,138 +18,355 @@
 #include <typeinfo>
 #include <new>
 #include <tuple>
+#include <utility>
 #include <type_traits>
 #include <bits/functexcept.h>
 #include <bits/functional_hash.h>
+#include <bits/allocated_ptr.h>
 #include <functional>
+#ifdef _GLIBCXX_UNIQUE_FUNCTION_STATS
+#include <atomic>
+#endif
 
 namespace std _GLIBCXX_VISIBILITY(default)
 {
 _GLIBCXX_BEGIN_NAMESPACE_VERSION
 
+  template<typename _Signature,
+	   std::size_t _Size = sizeof(_Nocopy_types),
+	   std::size_t _Align = __alignof__(_Nocopy_types)>
+    class basic_unique_function;
+
+  /**
+   *  @brief Polymorphic, move-only function wrapper with the default
+   *  inline capacity of std::function.
+   *
+   *  Use basic_unique_function directly to choose a larger buffer.
+   */
+  template<typename _Signature>
+    using unique_function = basic_unique_function<_Signature>;
+
   template<typename _Signature>
-    class unique_function;
+    class unique_function_ref;
+
+  // A per-type object whose address identifies _Tp without RTTI.  It is
+  // not const, so that it cannot be merged with the tag of another type.
+  template<typename _Tp>
+    struct _Unique_type_tag
+    { static char _S_id; };
+
+  template<typename _Tp>
+    char _Unique_type_tag<_Tp>::_S_id;
+
+  enum _Unique_Manager_operation
+  {
+    __unique_get_type_info,
+    __unique_get_functor_ptr,
+#ifdef _GLIBCXX_UNIQUE_FUNCTION_STATS
+    __unique_get_stats
+#endif
+  };
+
+#ifdef _GLIBCXX_UNIQUE_FUNCTION_STATS
+  /**
+   *  @brief Storage statistics for one target type, collected when
+   *  _GLIBCXX_UNIQUE_FUNCTION_STATS is defined.
+   *
+   *  One record exists for every target type that has been stored in a
+   *  basic_unique_function of any signature or buffer size.  The records
+   *  form a list that starts at unique_function_stats_list().  A target
+   *  held through reference_wrapper<F> is recorded as F*.
+   */
+  struct unique_function_stats
+  {
+    unique_function_stats(const char* __name, std::size_t __size,
+			  std::size_t __align) noexcept
+    : name(__name), size(__size), align(__align), inline_stores(0),
+      heap_stores(0), heap_bytes(0), moves(0), next(nullptr) { }
+
+    unique_function_stats(const unique_function_stats&) = delete;
+    unique_function_stats& operator=(const unique_function_stats&) = delete;
+
+    /// The mangled name of the target type, or null without RTTI.
+    const char* const		name;
+    const std::size_t		size;
+    const std::size_t		align;
+    /// Targets constructed in the local buffer of a wrapper.
+    atomic<std::size_t>		inline_stores;
+    /// Targets allocated on the heap, and the bytes allocated for them.
+    atomic<std::size_t>		heap_stores;
+    atomic<std::size_t>		heap_bytes;
+    /// Wrappers holding this target that were moved, swapped or relocated.
+    atomic<std::size_t>		moves;
+    /// The next record, or null.
+    const unique_function_stats* next;
+  };
+
+  inline atomic<unique_function_stats*>&
+  __unique_function_stats_head() noexcept
+  {
+    static atomic<unique_function_stats*> __head(nullptr);
+    return __head;
+  }
+
+  inline bool
+  __unique_function_stats_register(unique_function_stats& __s) noexcept
+  {
+    atomic<unique_function_stats*>& __head = __unique_function_stats_head();
+    unique_function_stats* __next = __head.load(memory_order_relaxed);
+    do
+      __s.next = __next;
+    while (!__head.compare_exchange_weak(__next, &__s,
+					 memory_order_release,
+					 memory_order_relaxed));
+    return true;
+  }
+
+  // The record for _Functor, created and linked into the list on first use.
+  template<typename _Functor>
+    unique_function_stats&
+    __unique_function_stats_for() noexcept
+    {
+      static unique_function_stats __s(
+#ifdef __GXX_RTTI
+	  typeid(_Functor).name(),
+#else
+	  nullptr,
+#endif
+	  sizeof(_Functor), __alignof__(_Functor));
+      static const bool __registered = __unique_function_stats_register(__s);
+      (void) __registered;
+      return __s;
+    }
+
+  /**
+   *  @brief The statistics of every target type stored so far.
+   *  @return The first record, or null if no target has been stored.
+   *
+   *  Records are only ever added, at the front, so a list obtained once
+   *  stays valid while other threads store new target types.
+   */
+  inline const unique_function_stats*
+  unique_function_stats_list() noexcept
+  { return __unique_function_stats_head().load(memory_order_acquire); }
+#endif
+
+  /**
+   *  Storage for the target of a basic_unique_function: at least @a _Size
+   *  bytes aligned to at least @a _Align, and always large enough to hold
+   *  a pointer to a heap-allocated target.
+   */
+  template<std::size_t _Size, std::size_t _Align>
+    union [[gnu::may_alias]] _Unique_Any_data
+    {
+      void*       _M_access()       noexcept { return &_M_pod_data[0]; }
+      const void* _M_access() const noexcept { return &_M_pod_data[0]; }
+
+      template<typename _Tp>
+	_Tp&
+	_M_access() noexcept
+	{ return *static_cast<_Tp*>(_M_access()); }
+
+      template<typename _Tp>
+	const _Tp&
+	_M_access() const noexcept
+	{ return *static_cast<const _Tp*>(_M_access()); }
+
+      _Nocopy_types _M_unused;
+      alignas(_Align) char _M_pod_data[_Size];
+    };
 
   /// Base class of all polymorphic function object wrappers.
+  template<std::size_t _Size, std::size_t _Align>
   class _Unique_Function_base
   {
+    static_assert(_Align != 0 && (_Align & (_Align - 1)) == 0,
+		  "unique_function alignment must be a power of two");
+
   public:
-    static const std::size_t _M_max_size = sizeof(_Nocopy_types);
-    static const std::size_t _M_max_align = __alignof__(_Nocopy_types);
+    typedef _Unique_Any_data<_Size, _Align> _Any_data;
+
+    static const std::size_t _M_max_size = sizeof(_Any_data);
+    static const std::size_t _M_max_align = __alignof__(_Any_data);
 
     template<typename _Functor>
       class _Base_manager
       {
-      protected:
+      public:
+	// Anything that can be moved without throwing may live in the
+	// local buffer, because swap and move relocate it through
+	// _M_move rather than copying the raw bytes.
 	static const bool __stored_locally =
-	(__is_location_invariant<_Functor>::value
+	(is_nothrow_move_constructible<_Functor>::value
 	 && sizeof(_Functor) <= _M_max_size
 	 && __alignof__(_Functor) <= _M_max_align
 	 && (_M_max_align % __alignof__(_Functor) == 0));
 
 	typedef integral_constant<bool, __stored_locally> _Local_storage;
 
+	// A target on the heap is owned through a pointer, and a local
+	// target that is location-invariant does not care where it lives,
+	// so in both cases the buffer can simply be copied elsewhere.
+	// Users may specialize __is_location_invariant to opt in.
+	static const bool __relocatable =
+	(!__stored_locally || __is_location_invariant<_Functor>::value);
+
+	// A local target with a trivial destructor, such as a function
+	// pointer or a captureless lambda, needs no destroy call at all.
+	static const bool __trivially_destroyed =
+	(__stored_locally && is_trivially_destructible<_Functor>::value);
+
+      protected:
 	// Retrieve a pointer to the function object
 	static _Functor*
 	_M_get_pointer(const _Any_data& __source)
 	{
 	  const _Functor* __ptr =
-	    __stored_locally? std::__addressof(__source._M_access<_Functor>())
-	    /* have stored a pointer */ : __source._M_access<_Functor*>();
+	    __stored_locally
+	    ? std::__addressof(__source.template _M_access<_Functor>())
+	    /* have stored a pointer */
+	    : __source.template _M_access<_Functor*>();
 	  return const_cast<_Functor*>(__ptr);
 	}
 
-	// Clone a location-invariant function object that fits within
-	// an _Any_data structure.
+	// Move a locally stored function object into __dest and destroy
+	// the moved-from object, leaving __source without a target.
 	static void
-	_M_clone(_Any_data& __dest, const _Any_data& __source, true_type)
+	_M_move(_Any_data& __dest, _Any_data& __source, true_type) noexcept
 	{
-	  new (__dest._M_access()) _Functor(__source._M_access<_Functor>());
+	  _Functor& __f = __source.template _M_access<_Functor>();
+	  new (__dest._M_access()) _Functor(std::move(__f));
+	  __f.~_Functor();
 	}
 
-	// Clone a function object that is not location-invariant or
-	// that cannot fit into an _Any_data structure.
+	// Hand the heap-allocated function object over to __dest.
 	static void
-	_M_clone(_Any_data& __dest, const _Any_data& __source, false_type)
+	_M_move(_Any_data& __dest, _Any_data& __source, false_type) noexcept
 	{
-	  __dest._M_access<_Functor*>() =
-	    new _Functor(*__source._M_access<_Functor*>());
+	  __dest.template _M_access<_Functor*>()
+	    = __source.template _M_access<_Functor*>();
 	}
 
-	// Destroying a location-invariant object may still require
+	// Destroying a locally stored object may still require
 	// destruction.
 	static void
 	_M_destroy(_Any_data& __victim, true_type)
 	{
-	  __victim._M_access<_Functor>().~_Functor();
+	  __victim.template _M_access<_Functor>().~_Functor();
 	}
 
 	// Destroying an object located on the heap.
 	static void
 	_M_destroy(_Any_data& __victim, false_type)
 	{
-	  delete __victim._M_access<_Functor*>();
+	  delete __victim.template _M_access<_Functor*>();
 	}
 
       public:
+	static void
+	_M_move(_Any_data& __dest, _Any_data& __source) noexcept
+	{ _M_move(__dest, __source, _Local_storage()); }
+
+	static void
+	_M_destroy(_Any_data& __victim)
+	{ _M_destroy(__victim, _Local_storage()); }
+
 	static bool
 	_M_manager(_Any_data& __dest, const _Any_data& __source,
-		   _Manager_operation __op)
+		   _Unique_Manager_operation __op)
 	{
 	  switch (__op)
 	    {
 #ifdef __GXX_RTTI
-	    case __get_type_info:
-	      __dest._M_access<const type_info*>() = &typeid(_Functor);
+	    case __unique_get_type_info:
+	      __dest.template _M_access<const type_info*>() = &typeid(_Functor);
 	      break;
 #endif
-	    case __get_functor_ptr:
-	      __dest._M_access<_Functor*>() = _M_get_pointer(__source);
+	    case __unique_get_functor_ptr:
+	      __dest.template _M_access<_Functor*>() = _M_get_pointer(__source);
 	      break;
-
-	    case __clone_functor:
-	      _M_clone(__dest, __source, _Local_storage());
-	      break;
-
-	    case __destroy_functor:
-	      _M_destroy(__dest, _Local_storage());
+#ifdef _GLIBCXX_UNIQUE_FUNCTION_STATS
+	    case __unique_get_stats:
+	      __dest.template _M_access<unique_function_stats*>()
+		= &__unique_function_stats_for<_Functor>();
 	      break;
+#endif
 	    }
 	  return false;
 	}
 
-	static void
-	_M_init_functor(_Any_data& __functor, _Functor&& __f)
-	{ _M_init_functor(__functor, std::move(__f), _Local_storage()); }
+	// Construct the target from __args directly in its final location,
+	// either the local buffer or a new heap allocation.
+	template<typename... _Args>
+	  static void
+	  _M_init_functor(_Any_data& __functor, _Args&&... __args)
+	  {
+	    _M_create(__functor, _Local_storage(),
+		      std::forward<_Args>(__args)...);
+	  }
 
-	template<typename _Signature>
-	  static bool
-	  _M_not_empty_function(const unique_function<_Signature>& __f)
+	template<typename _Signature, std::size_t _Sz, std::size_t _Al>
+	  static _GLIBCXX20_CONSTEXPR bool
+	  _M_not_empty_function(
+	      const basic_unique_function<_Signature, _Sz, _Al>& __f)
 	  { return static_cast<bool>(__f); }
 
 	template<typename _Tp>
-	  static bool
+	  static _GLIBCXX20_CONSTEXPR bool
 	  _M_not_empty_function(_Tp* const& __fp)
 	  { return __fp; }
 
 	template<typename _Class, typename _Tp>
-	  static bool
+	  static _GLIBCXX20_CONSTEXPR bool
 	  _M_not_empty_function(_Tp _Class::* const& __mp)
 	  { return __mp; }
 
 	template<typename _Tp>
-	  static bool
+	  static _GLIBCXX20_CONSTEXPR bool
 	  _M_not_empty_function(const _Tp&)
 	  { return true; }
 
-      private:
+      protected:
+	// Record that a target was stored, inline if __heap_bytes is zero.
 	static void
-	_M_init_functor(_Any_data& __functor, _Functor&& __f, true_type)
-	{ new (__functor._M_access()) _Functor(std::move(__f)); }
+	_M_note_store(std::size_t __heap_bytes) noexcept
+	{
+#ifdef _GLIBCXX_UNIQUE_FUNCTION_STATS
+	  unique_function_stats& __s = __unique_function_stats_for<_Functor>();
+	  if (__heap_bytes)
+	    {
+	      __s.heap_stores.fetch_add(1, memory_order_relaxed);
+	      __s.heap_bytes.fetch_add(__heap_bytes, memory_order_relaxed);
+	    }
+	  else
+	    __s.inline_stores.fetch_add(1, memory_order_relaxed);
+#else
+	  (void) __heap_bytes;
+#endif
+	}
 
-	static void
-	_M_init_functor(_Any_data& __functor, _Functor&& __f, false_type)
-	{ __functor._M_access<_Functor*>() = new _Functor(std::move(__f)); }
+      private:
+	template<typename... _Args>
+	  static void
+	  _M_create(_Any_data& __dest, true_type, _Args&&... __args)
+	  {
+	    // The buffer is relocated by copying all of it, so a target
+	    // that does not fill it, such as an empty class, must not leave
+	    // the remaining bytes indeterminate.
+	    if (sizeof(_Functor) < sizeof(_Any_data))
+	      __dest = _Any_data();
+	    ::new (__dest._M_access()) _Functor(std::forward<_Args>(__args)...);
+	    _M_note_store(0);
+	  }
+
+	template<typename... _Args>
+	  static void
+	  _M_create(_Any_data& __dest, false_type, _Args&&... __args)
+	  {
+	    __dest.template _M_access<_Functor*>()
+	      = new _Functor(std::forward<_Args>(__args)...);
+	    _M_note_store(sizeof(_Functor));
+	  }
       };
 
     template<typename _Functor>
@@ -160,17 +377,18 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
       public:
 	static bool
 	_M_manager(_Any_data& __dest, const _Any_data& __source,
-		   _Manager_operation __op)
+		   _Unique_Manager_operation __op)
 	{
 	  switch (__op)
 	    {
 #ifdef __GXX_RTTI
-	    case __get_type_info:
-	      __dest._M_access<const type_info*>() = &typeid(_Functor);
+	    case __unique_get_type_info:
+	      __dest.template _M_access<const type_info*>() = &typeid(_Functor);
 	      break;
 #endif
-	    case __get_functor_ptr:
-	      __dest._M_access<_Functor*>() = *_Base::_M_get_pointer(__source);
+	    case __unique_get_functor_ptr:
+	      __dest.template _M_access<_Functor*>()
+		= *_Base::_M_get_pointer(__source);
 	      return is_const<_Functor>::value;
 	      break;
 
@@ -180,228 +398,606 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
 	  return false;
 	}
 
+	template<typename... _Args>
+	  static void
+	  _M_init_functor(_Any_data& __functor, _Args&&... __args)
+	  {
+	    reference_wrapper<_Functor> __f(std::forward<_Args>(__args)...);
+	    _Base::_M_init_functor(__functor, std::__addressof(__f.get()));
+	  }
+      };
+
+    // Manages a function object that does not fit locally and was
+    // allocated with a user-supplied allocator.  The allocator is kept
+    // next to the target in the same block so that the manager can
+    // release the block without any help from the wrapper.
+    template<typename _Functor, typename _Alloc>
+      class _Alloc_manager : public _Base_manager<_Functor>
+      {
+	typedef _Unique_Function_base::_Base_manager<_Functor> _Base;
+
+	static_assert(!_Base::__stored_locally,
+		      "locally stored targets never use the allocator");
+
+	struct _Block
+	{
+	  typedef typename allocator_traits<_Alloc>::template
+	    rebind_alloc<_Block> allocator_type;
+
+	  _Block(_Functor&& __f, const allocator_type& __a)
+	  : _M_functor(std::move(__f)), _M_alloc(__a) { }
+
+	  _Functor       _M_functor;
+	  allocator_type _M_alloc;
+	};
+
+	typedef typename _Block::allocator_type _Block_alloc;
+
+	static _Block*
+	_M_create(_Functor&& __f, const _Block_alloc& __a)
+	{
+	  _Block_alloc __alloc(__a);
+	  auto __guard = std::__allocate_guarded(__alloc);
+	  _Block* __block = __guard.get();
+	  ::new (__block) _Block(std::move(__f), __a);
+	  __guard = nullptr;
+	  _Base::_M_note_store(sizeof(_Block));
+	  return __block;
+	}
+
+      protected:
+	static _Functor*
+	_M_get_pointer(const _Any_data& __source)
+	{
+	  return std::__addressof(
+	      __source.template _M_access<_Block*>()->_M_functor);
+	}
+
+      public:
 	static void
-	_M_init_functor(_Any_data& __functor, reference_wrapper<_Functor> __f)
+	_M_move(_Any_data& __dest, _Any_data& __source) noexcept
 	{
-	  _Base::_M_init_functor(__functor, std::__addressof(__f.get()));
+	  __dest.template _M_access<_Block*>()
+	    = __source.template _M_access<_Block*>();
 	}
-      };
 
-    _Unique_Function_base() : _M_manager(0) { }
+	static void
+	_M_destroy(_Any_data& __victim)
+	{
+	  _Block* __block = __victim.template _M_access<_Block*>();
+	  _Block_alloc __alloc(std::move(__block->_M_alloc));
+	  __allocated_ptr<_Block_alloc> __guard{__alloc, __block};
+	  __block->~_Block();
+	}
 
-    ~_Unique_Function_base()
-    {
-      if (_M_manager)
-	_M_manager(_M_functor, _M_functor, __destroy_functor);
-    }
+	static bool
+	_M_manager(_Any_data& __dest, const _Any_data& __source,
+		   _Unique_Manager_operation __op)
+	{
+	  switch (__op)
+	    {
+	    case __unique_get_functor_ptr:
+	      __dest.template _M_access<_Functor*>() = _M_get_pointer(__source);
+	      break;
 
+	    default:
+	      _Base::_M_manager(__dest, __source, __op);
+	    }
+	  return false;
+	}
 
-    bool _M_empty() const { return !_M_manager; }
+	static void
+	_M_init_functor(_Any_data& __functor, _Functor&& __f, const _Alloc& __a)
+	{
+	  __functor.template _M_access<_Block*>()
+	    = _M_create(std::move(__f), _Block_alloc(__a));
+	}
+      };
 
     typedef bool (*_Manager_type)(_Any_data&, const _Any_data&,
-				  _Manager_operation);
+				  _Unique_Manager_operation);
+    typedef void (*_Move_type)(_Any_data&, _Any_data&);
+    typedef void (*_Destroy_type)(_Any_data&);
+
+    // The per-target operations shared by every wrapper holding a target
+    // of the same type.  A wrapper stores a single pointer to one of
+    // these instead of separate invoker and manager pointers.  _M_move
+    // is null when the target can be relocated by copying the buffer,
+    // and _M_destroy is null when it needs no destruction.
+    // _M_invoke_target calls the target given its address, which lets a
+    // unique_function_ref bind to the target of a wrapper.  _M_type is
+    // the _Unique_type_tag of the target type, or null when empty.
+    template<typename _Invoker, typename _Target_invoker>
+      struct _Vtable
+      {
+	_Invoker	_M_invoke;
+	_Move_type	_M_move;
+	_Destroy_type	_M_destroy;
+	_Manager_type	_M_manager;
+	_Target_invoker	_M_invoke_target;
+	const void*	_M_type;
+      };
 
-    _Any_data     _M_functor;
-    _Manager_type _M_manager;
-  };
+    template<typename _Manager>
+      static constexpr _Move_type
+      _S_move_op()
+      {
+	return _Manager::__relocatable
+	  ? _Move_type() : _Move_type(&_Manager::_M_move);
+      }
 
-  template<typename _Signature, typename _Functor>
-    class _Unique_Function_handler;
+    template<typename _Manager>
+      static constexpr _Destroy_type
+      _S_destroy_op()
+      {
+	return _Manager::__trivially_destroyed
+	  ? _Destroy_type() : _Destroy_type(&_Manager::_M_destroy);
+      }
 
-  template<typename _Res, typename _Functor, typename... _ArgTypes>
-    class _Unique_Function_handler<_Res(_ArgTypes...), _Functor>
-    : public _Unique_Function_base::_Base_manager<_Functor>
-    {
-      typedef _Unique_Function_base::_Base_manager<_Functor> _Base;
+    // Destroy the target described by __vtable, if it needs it.
+    template<typename _Vt>
+      static _GLIBCXX20_CONSTEXPR void
+      _S_destroy(const _Vt* __vtable, _Any_data& __victim) noexcept
+      {
+	if (__vtable->_M_destroy)
+	  __vtable->_M_destroy(__victim);
+      }
 
-    public:
-      static _Res
-      _M_invoke(const _Any_data& __functor, _ArgTypes... __args)
+    // Relocate the target described by __vtable from __source to __dest.
+    template<typename _Vt>
+      static void
+      _S_relocate(const _Vt* __vtable, _Any_data& __dest,
+		  _Any_data& __source) noexcept
       {
-	return (*_Base::_M_get_pointer(__functor))(
-	    std::forward<_ArgTypes>(__args)...);
+	_S_note_move(__vtable, __source);
+	if (__vtable->_M_move)
+	  __vtable->_M_move(__dest, __source);
+	else
+	  __dest = __source;
       }
-    };
 
-  template<typename _Functor, typename... _ArgTypes>
-    class _Unique_Function_handler<void(_ArgTypes...), _Functor>
-    : public _Unique_Function_base::_Base_manager<_Functor>
-    {
-      typedef _Unique_Function_base::_Base_manager<_Functor> _Base;
+    // Move the target of the wrapper whose vtable is __src_vtable into
+    // __dest, a wrapper without a target, and leave the source empty.
+    // __empty is the vtable of an empty wrapper of that type.
+    template<typename _Vt>
+      static void
+      _S_move_target(const _Vt*& __dest_vtable, _Any_data& __dest,
+		     const _Vt*& __src_vtable, _Any_data& __source,
+		     const _Vt* __empty) noexcept
+      {
+	__dest_vtable = __src_vtable;
+	if (__src_vtable != __empty)
+	  {
+	    _S_relocate(__src_vtable, __dest, __source);
+	    __src_vtable = __empty;
+	  }
+      }
 
-     public:
+    // Exchange the targets of two wrappers.  Local targets may not be
+    // location-invariant, so they are relocated through their vtables
+    // instead of swapping bytes.
+    template<typename _Vt>
       static void
-      _M_invoke(const _Any_data& __functor, _ArgTypes... __args)
+      _S_swap(const _Vt*& __x_vtable, _Any_data& __x,
+	      const _Vt*& __y_vtable, _Any_data& __y,
+	      const _Vt* __empty) noexcept
       {
-	(*_Base::_M_get_pointer(__functor))(
-	    std::forward<_ArgTypes>(__args)...);
+	if (std::__addressof(__x) == std::__addressof(__y))
+	  return;
+	_Any_data __tmp;
+	if (__y_vtable != __empty)
+	  _S_relocate(__y_vtable, __tmp, __y);
+	if (__x_vtable != __empty)
+	  _S_relocate(__x_vtable, __y, __x);
+	if (__y_vtable != __empty)
+	  _S_relocate(__y_vtable, __x, __tmp);
+	std::swap(__x_vtable, __y_vtable);
       }
+
+    // Record that the target described by __vtable is being moved.
+    template<typename _Vt>
+      static void
+      _S_note_move(const _Vt* __vtable,
+		   const _Any_data& __source) noexcept
+      {
+#ifdef _GLIBCXX_UNIQUE_FUNCTION_STATS
+	_Any_data __stats;
+	__stats.template _M_access<unique_function_stats*>() = nullptr;
+	__vtable->_M_manager(__stats, __source, __unique_get_stats);
+	if (unique_function_stats* __s
+	      = __stats.template _M_access<unique_function_stats*>())
+	  __s->moves.fetch_add(1, memory_order_relaxed);
+#else
+	(void) __vtable;
+	(void) __source;
+#endif
+      }
+
+    // Operations behind the vtable of a wrapper without a target.
+    struct _Empty_manager
+    {
+      static bool
+      _M_manager(_Any_data&, const _Any_data&, _Unique_Manager_operation)
+      { return false; }
     };
+  };
 
-  template<typename _Res, typename _Functor, typename... _ArgTypes>
-    class _Unique_Function_handler<_Res(_ArgTypes...), reference_wrapper<_Functor> >
-    : public _Unique_Function_base::_Ref_manager<_Functor>
+  template<typename _From, typename _To>
+    using __check_func_return_type
+      = __or_<is_void<_To>, is_convertible<_From, _To>>;
+
+  template<typename _Signature, bool _Nothrow>
+    struct _Unique_Function_invoker;
+
+  /**
+   *  The parts of the call machinery for the signature _Res(_ArgTypes...)
+   *  that do not depend on the storage of a wrapper, shared by
+   *  basic_unique_function and unique_function_ref.
+   */
+  template<typename _Res, typename... _ArgTypes, bool _Nothrow>
+    struct _Unique_Function_invoker<_Res(_ArgTypes...), _Nothrow>
     {
-      typedef _Unique_Function_base::_Ref_manager<_Functor> _Base;
+      typedef _Res (*_Target_invoker_type)(void*, _ArgTypes...);
 
-     public:
-      static _Res
-      _M_invoke(const _Any_data& __functor, _ArgTypes... __args)
-      {
-	return __callable_functor(**_Base::_M_get_pointer(__functor))(
+      // Whether a target invoked as _Tp, i.e. with the cv and reference
+      // qualifiers of the signature applied, can be called with it.
+      template<typename _Tp>
+	using _Is_callable
+	  = __and_<__check_func_return_type<
+		     typename __invoke_result<_Tp, _ArgTypes...>::type, _Res>,
+		   __or_<__bool_constant<!_Nothrow>,
+			 __is_nothrow_invocable<_Tp, _ArgTypes...>>>;
+
+      // Invoke the object at __target as _Tp.
+      template<typename _Tp>
+	static _Res
+	_S_invoke_target(void* __target, _ArgTypes... __args)
+	noexcept(_Nothrow)
+	{
+	  typedef typename remove_reference<_Tp>::type _Obj;
+	  return std::__invoke_r<_Res>(
+	      static_cast<_Tp>(*static_cast<_Obj*>(__target)),
 	      std::forward<_ArgTypes>(__args)...);
-      }
+	}
+
+      // Invoke the function whose address was stored in __target.
+      template<typename _Fn>
+	static _Res
+	_S_invoke_function(void* __target, _ArgTypes... __args)
+	noexcept(_Nothrow)
+	{
+	  return std::__invoke_r<_Res>(reinterpret_cast<_Fn*>(__target),
+				       std::forward<_ArgTypes>(__args)...);
+	}
+
+      static _Res
+      _S_empty_invoke_target(void*, _ArgTypes...)
+      { __throw_bad_function_call(); }
     };
 
-  template<typename _Functor, typename... _ArgTypes>
-    class _Unique_Function_handler<void(_ArgTypes...), reference_wrapper<_Functor> >
-    : public _Unique_Function_base::_Ref_manager<_Functor>
+  template<typename _Signature, typename _Function_base, bool _Nothrow>
+    class _Unique_Function_data;
+
+  /**
+   *  State shared by every qualified form of the signature
+   *  _Res(_ArgTypes...): the storage for the target and the pointer to
+   *  its vtable.  @a _Nothrow is true for noexcept signatures.
+   *
+   *  The storage shares a union with a pointer to a function of exactly
+   *  the signature, so that such a pointer can be stored by assignment
+   *  during constant evaluation, where placement new into the buffer is
+   *  not allowed.  The invokers read it back through the buffer.
+   */
+  template<typename _Res, typename... _ArgTypes, typename _Function_base,
+	   bool _Nothrow>
+    class _Unique_Function_data<_Res(_ArgTypes...), _Function_base, _Nothrow>
+    : public _Maybe_unary_or_binary_function<_Res, _ArgTypes...>,
+      public _Unique_Function_invoker<_Res(_ArgTypes...), _Nothrow>,
+      protected _Function_base
     {
-      typedef _Unique_Function_base::_Ref_manager<_Functor> _Base;
+    protected:
+      typedef typename _Function_base::_Any_data _Any_data;
+      typedef _Unique_Function_invoker<_Res(_ArgTypes...), _Nothrow>
+	_Invoker;
 
-     public:
-      static void
-      _M_invoke(const _Any_data& __functor, _ArgTypes... __args)
+    public:
+      typedef _Res result_type;
+
+#if __cplusplus > 201402L
+      typedef _Res (*_Function_ptr)(_ArgTypes...) noexcept(_Nothrow);
+#else
+      typedef _Res (*_Function_ptr)(_ArgTypes...);
+#endif
+
+      typedef _Res (*_Invoker_type)(const _Any_data&, _ArgTypes...);
+      typedef typename _Invoker::_Target_invoker_type _Target_invoker_type;
+      typedef typename _Function_base::template
+	_Vtable<_Invoker_type, _Target_invoker_type> _Vtable;
+
+      // The invoker for a target reached through _Handler::_M_get_target
+      // and invoked as _Tp.
+      template<typename _Handler, typename _Tp>
+	static _Res
+	_S_invoke(const _Any_data& __functor, _ArgTypes... __args)
+	noexcept(_Nothrow)
+	{
+	  return std::__invoke_r<_Res>(
+	      static_cast<_Tp>(*_Handler::_M_get_target(__functor)),
+	      std::forward<_ArgTypes>(__args)...);
+	}
+
+    protected:
+      _GLIBCXX20_CONSTEXPR
+      _Unique_Function_data() noexcept
+      : _M_vtable(&_S_empty_vtable)
       {
-	__callable_functor(**_Base::_M_get_pointer(__functor))(
-	    std::forward<_ArgTypes>(__args)...);
+#if __cplusplus > 201703L
+	// The result of a constant initialization must not leave the
+	// storage indeterminate, even when no target is stored in it.
+	if (std::is_constant_evaluated())
+	  _M_function_pointer = nullptr;
+#endif
       }
-    };
 
-  template<typename _Class, typename _Member, typename _Res,
-	   typename... _ArgTypes>
-    class _Unique_Function_handler<_Res(_ArgTypes...), _Member _Class::*>
-    : public _Unique_Function_handler<void(_ArgTypes...), _Member _Class::*>
-    {
-      typedef _Unique_Function_handler<void(_ArgTypes...), _Member _Class::*>
-	_Base;
+      bool _M_empty() const noexcept { return _M_vtable == &_S_empty_vtable; }
 
-     public:
       static _Res
-      _M_invoke(const _Any_data& __functor, _ArgTypes... __args)
+      _S_empty_invoke(const _Any_data&, _ArgTypes...)
+      { __throw_bad_function_call(); }
+
+      typedef typename _Function_base::_Empty_manager _Empty_manager;
+
+      static constexpr _Vtable _S_empty_vtable
+	= { &_S_empty_invoke, nullptr, nullptr, &_Empty_manager::_M_manager,
+	    &_Invoker::_S_empty_invoke_target, nullptr };
+
+      union
       {
-	return std::mem_fn(_Base::_M_get_pointer(__functor)->__value)(
-	    std::forward<_ArgTypes>(__args)...);
-      }
+	_Any_data	_M_functor;
+	_Function_ptr	_M_function_pointer;
+      };
+      const _Vtable* _M_vtable;
     };
 
-  template<typename _Class, typename _Member, typename... _ArgTypes>
-    class _Unique_Function_handler<void(_ArgTypes...), _Member _Class::*>
-    : public _Unique_Function_base::_Base_manager<
-		 _Simple_type_wrapper< _Member _Class::* > >
+#if __cplusplus < 201703L
+  template<typename _Res, typename... _ArgTypes, typename _Function_base,
+	   bool _Nothrow>
+    constexpr typename _Unique_Function_data<_Res(_ArgTypes...),
+					     _Function_base, _Nothrow>::_Vtable
+    _Unique_Function_data<_Res(_ArgTypes...), _Function_base, _Nothrow>::
+    _S_empty_vtable;
+#endif
+
+  /**
+   *  The call operators of a basic_unique_function, one partial
+   *  specialization per qualified signature.
+   *
+   *  As for std::move_only_function, the cv-qualifier and ref-qualifier
+   *  of the signature are applied both to operator() and to the target
+   *  when it is invoked, so a @c R(A...) @c const signature requires a
+   *  target that is callable as a const lvalue.  An unqualified
+   *  signature invokes the target as a non-const lvalue and therefore
+   *  has a non-const operator().  Calling an empty wrapper whose
+   *  signature is @c noexcept throws bad_function_call out of a
+   *  @c noexcept function, which calls std::terminate.
+   */
+  template<typename _Signature, typename _Function_base>
+    class _Unique_Function_call;
+
+#define _GLIBCXX_UNIQUE_FUNCTION_CALL2(_CV, _REF, _INV_REF, _NOEXCEPT, _NE) \
+  template<typename _Res, typename... _ArgTypes, typename _Function_base> \
+    class _Unique_Function_call<_Res(_ArgTypes...) _CV _REF _NOEXCEPT,	\
+				_Function_base>				\
+    : public _Unique_Function_data<_Res(_ArgTypes...), _Function_base, _NE> \
+    {									\
+    public:								\
+      template<typename _Tp>						\
+	using _Target = _Tp _CV _INV_REF;				\
+									\
+      _Res								\
+      operator()(_ArgTypes... __args) _CV _REF _NOEXCEPT		\
+      {									\
+	return this->_M_vtable->_M_invoke(this->_M_functor,		\
+					  std::forward<_ArgTypes>(__args)...); \
+      }									\
+									\
+      _Res								\
+      invoke_unchecked(_ArgTypes... __args) _CV _REF _NOEXCEPT		\
+      {									\
+	__glibcxx_assert(!this->_M_empty());				\
+	return this->_M_vtable->_M_invoke(this->_M_functor,		\
+					  std::forward<_ArgTypes>(__args)...); \
+      }									\
+    };
+
+#define _GLIBCXX_UNIQUE_FUNCTION_CALL(_NOEXCEPT, _NE)			\
+  _GLIBCXX_UNIQUE_FUNCTION_CALL2(     ,   , &,  _NOEXCEPT, _NE)		\
+  _GLIBCXX_UNIQUE_FUNCTION_CALL2(const,   , &,  _NOEXCEPT, _NE)		\
+  _GLIBCXX_UNIQUE_FUNCTION_CALL2(     , & , &,  _NOEXCEPT, _NE)		\
+  _GLIBCXX_UNIQUE_FUNCTION_CALL2(const, & , &,  _NOEXCEPT, _NE)		\
+  _GLIBCXX_UNIQUE_FUNCTION_CALL2(     , &&, &&, _NOEXCEPT, _NE)		\
+  _GLIBCXX_UNIQUE_FUNCTION_CALL2(const, &&, &&, _NOEXCEPT, _NE)
+
+_GLIBCXX_UNIQUE_FUNCTION_CALL(, false)
+#if __cplusplus > 201402L
+_GLIBCXX_UNIQUE_FUNCTION_CALL(noexcept, true)
+#endif
+
+#undef _GLIBCXX_UNIQUE_FUNCTION_CALL
+#undef _GLIBCXX_UNIQUE_FUNCTION_CALL2
+
+  template<typename _Signature, typename _Functor, typename _Function_base,
+	   typename _Manager
+	     = typename _Function_base::template _Base_manager<_Functor>>
+    class _Unique_Function_handler : public _Manager
     {
-      typedef _Member _Class::* _Functor;
-      typedef _Simple_type_wrapper<_Functor> _Wrapper;
-      typedef _Unique_Function_base::_Base_manager<_Wrapper> _Base;
+      typedef _Manager _Base;
+      typedef typename _Function_base::_Any_data _Any_data;
+      typedef _Unique_Function_call<_Signature, _Function_base> _Call;
 
     public:
-      static bool
-      _M_manager(_Any_data& __dest, const _Any_data& __source,
-		 _Manager_operation __op)
-      {
-	switch (__op)
-	  {
-#ifdef __GXX_RTTI
-	  case __get_type_info:
-	    __dest._M_access<const type_info*>() = &typeid(_Functor);
-	    break;
+      typedef typename _Call::_Vtable _Vtable;
+
+      static _Functor*
+      _M_get_target(const _Any_data& __functor)
+      { return _Base::_M_get_pointer(__functor); }
+
+      static constexpr _Vtable _S_vtable
+	= { &_Call::template _S_invoke<_Unique_Function_handler,
+				       typename _Call::template
+					 _Target<_Functor>>,
+	    _Function_base::template _S_move_op<_Base>(),
+	    _Function_base::template _S_destroy_op<_Base>(),
+	    &_Base::_M_manager,
+	    &_Call::template _S_invoke_target<typename _Call::template
+						_Target<_Functor>>,
+	    &_Unique_type_tag<_Functor>::_S_id };
+    };
+
+#if __cplusplus < 201703L
+  template<typename _Signature, typename _Functor, typename _Function_base,
+	   typename _Manager>
+    constexpr typename _Unique_Function_handler<_Signature, _Functor,
+						_Function_base, _Manager>::_Vtable
+    _Unique_Function_handler<_Signature, _Functor,
+			     _Function_base, _Manager>::_S_vtable;
 #endif
-	  case __get_functor_ptr:
-	    __dest._M_access<_Functor*>() =
-	      &_Base::_M_get_pointer(__source)->__value;
-	    break;
 
-	  default:
-	    _Base::_M_manager(__dest, __source, __op);
-	  }
-	return false;
-      }
+  template<typename _Signature, typename _Functor, typename _Function_base>
+    class _Unique_Function_handler<_Signature,
+				   reference_wrapper<_Functor>, _Function_base,
+				   typename _Function_base::template
+				     _Base_manager<reference_wrapper<_Functor>>>
+    : public _Function_base::template _Ref_manager<_Functor>
+    {
+      typedef typename _Function_base::template _Ref_manager<_Functor> _Base;
+      typedef typename _Function_base::_Any_data _Any_data;
+      typedef _Unique_Function_call<_Signature, _Function_base> _Call;
 
-      static void
-      _M_invoke(const _Any_data& __functor, _ArgTypes... __args)
-      {
-	std::mem_fn(_Base::_M_get_pointer(__functor)->__value)(
-	    std::forward<_ArgTypes>(__args)...);
-      }
+     public:
+      typedef typename _Call::_Vtable _Vtable;
+
+      static _Functor*
+      _M_get_target(const _Any_data& __functor)
+      { return *_Base::_M_get_pointer(__functor); }
+
+    private:
+      typedef typename _Call::_Target_invoker_type _Target_invoker_type;
+
+      // The address of a referenced function is passed to the target
+      // invoker as the function pointer itself, not as an object pointer.
+      static constexpr _Target_invoker_type
+      _S_target_invoker(false_type)
+      { return &_Call::template _S_invoke_target<_Functor&>; }
+
+      static constexpr _Target_invoker_type
+      _S_target_invoker(true_type)
+      { return &_Call::template _S_invoke_function<_Functor>; }
+
+    public:
+      // The referent is always invoked as an lvalue, whatever the
+      // qualifiers of the signature.
+      static constexpr _Vtable _S_vtable
+	= { &_Call::template _S_invoke<_Unique_Function_handler, _Functor&>,
+	    _Function_base::template _S_move_op<_Base>(),
+	    _Function_base::template _S_destroy_op<_Base>(),
+	    &_Base::_M_manager,
+	    _S_target_invoker(is_function<_Functor>()),
+	    &_Unique_type_tag<typename remove_cv<_Functor>::type>::_S_id };
     };
 
-  template<typename _From, typename _To>
-    using __check_func_return_type
-      = __or_<is_void<_To>, is_convertible<_From, _To>>;
+#if __cplusplus < 201703L
+  template<typename _Signature, typename _Functor, typename _Function_base>
+    constexpr typename _Unique_Function_handler<_Signature,
+      reference_wrapper<_Functor>, _Function_base,
+      typename _Function_base::template
+	_Base_manager<reference_wrapper<_Functor>>>::_Vtable
+    _Unique_Function_handler<_Signature,
+      reference_wrapper<_Functor>, _Function_base,
+      typename _Function_base::template
+	_Base_manager<reference_wrapper<_Functor>>>::_S_vtable;
+#endif
 
   /**
-   *  @brief Primary class template for std::unique_function.
+   *  @brief Primary class template for std::basic_unique_function.
    *  @ingroup functors
    *
-   *  Polymorphic function wrapper.
+   *  Polymorphic function wrapper.  Targets that are nothrow move
+   *  constructible and fit within @a _Size bytes aligned to @a _Align are
+   *  stored inside the wrapper; anything else is allocated on the heap.
+   *
+   *  @a _Signature is a function type @c R(A...), optionally followed by
+   *  @c const, a ref-qualifier and (since C++17) @c noexcept, with the
+   *  same meaning as for std::move_only_function.
    */
-  template<typename _Res, typename... _ArgTypes>
-    class unique_function<_Res(_ArgTypes...)>
-    : public _Maybe_unary_or_binary_function<_Res, _ArgTypes...>,
-      private _Unique_Function_base
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
+    class basic_unique_function
+    : public _Unique_Function_call<_Signature,
+				   _Unique_Function_base<_Size, _Align>>
     {
-      typedef _Res _Signature_type(_ArgTypes...);
+      typedef _Unique_Function_base<_Size, _Align> _Function_base;
+      typedef _Unique_Function_call<_Signature, _Function_base> _Call;
+      typedef typename _Function_base::_Any_data _Any_data;
+      typedef typename _Call::_Vtable _Vtable;
 
-      template<typename _Functor>
-	using _Invoke = decltype(__callable_functor(std::declval<_Functor&>())
-				 (std::declval<_ArgTypes>()...) );
+      using _Call::_M_functor;
+      using _Call::_M_function_pointer;
+      using _Call::_M_vtable;
+      using _Call::_M_empty;
+      using _Call::_S_empty_vtable;
 
       // Used so the return type convertibility checks aren't done when
       // performing overload resolution for copy construction/assignment.
       template<typename _Tp>
-	using _NotSelf = __not_<is_same<_Tp, unique_function>>;
+	using _NotSelf = __not_<is_same<_Tp, basic_unique_function>>;
 
       template<typename _Functor>
 	using _Callable
 	  = __and_<_NotSelf<_Functor>,
-		   __check_func_return_type<_Invoke<_Functor>, _Res>>;
+		   typename _Call::template _Is_callable<
+		     typename _Call::template _Target<_Functor>>>;
 
       template<typename _Cond, typename _Tp>
 	using _Requires = typename enable_if<_Cond::value, _Tp>::type;
 
     public:
-      typedef _Res result_type;
-
       // [3.7.2.1] construct/copy/destroy
 
       /**
        *  @brief Default construct creates an empty function call wrapper.
        *  @post @c !(bool)*this
        */
-      unique_function() noexcept
-      : _Unique_Function_base() { }
+      _GLIBCXX20_CONSTEXPR
+      basic_unique_function() noexcept { }
 
       /**
        *  @brief Creates an empty function call wrapper.
        *  @post @c !(bool)*this
        */
-      unique_function(nullptr_t) noexcept
-      : _Unique_Function_base() { }
+      _GLIBCXX20_CONSTEXPR
+      basic_unique_function(nullptr_t) noexcept { }
 
       /**
-       *  @brief %Function copy constructor.
-       *  @param __x A %function object with identical call signature.
-       *  @post @c bool(*this) == bool(__x)
-       *
-       *  The newly-created %function contains a copy of the target of @a
-       *  __x (if it has one).
+       *  @brief A %unique_function cannot be copied; its target is never
+       *  required to be copy constructible.
        */
-      unique_function(const unique_function& __x);
+      basic_unique_function(const basic_unique_function&) = delete;
 
       /**
        *  @brief %Function move constructor.
        *  @param __x A %function object rvalue with identical call signature.
        *
        *  The newly-created %function contains the target of @a __x
-       *  (if it has one).
+       *  (if it has one), and @a __x is left empty.  Only nothrow
+       *  movable targets are stored locally, so relocating the target
+       *  cannot throw.
        */
-      unique_function(unique_function&& __x) : _Unique_Function_base()
+      basic_unique_function(basic_unique_function&& __x) noexcept
       {
-	__x.swap(*this);
+	_Function_base::_S_move_target(_M_vtable, _M_functor, __x._M_vtable,
+				       __x._M_functor, &_S_empty_vtable);
       }
 
-      // TODO: needs allocator_arg_t
-
       /**
        *  @brief Builds a %function that targets a copy of the incoming
        *  function object.
@@ -417,45 +1013,87 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
        *
        *  If @a __f is a non-NULL function pointer or an object of type @c
        *  reference_wrapper<F>, this function will not throw.
+       *
+       *  @a __f is forwarded straight into the storage for the target, so
+       *  an rvalue is moved exactly once and an lvalue copied once.
+       *
+       *  Since C++20 the constructor is @c constexpr, and a wrapper can be
+       *  constant-initialized with a pointer to a function of exactly the
+       *  signature, or with an empty trivially copyable object such as a
+       *  captureless lambda.  Other targets are stored at run time.
        */
       template<typename _Functor,
-	       typename = _Requires<_Callable<_Functor>, void>>
-	unique_function(_Functor);
+	       typename = _Requires<_Callable<typename decay<_Functor>::type>,
+				    void>>
+	_GLIBCXX20_CONSTEXPR
+	basic_unique_function(_Functor&& __f);
 
+#if __cplusplus > 201402L
       /**
-       *  @brief %Function assignment operator.
-       *  @param __x A %function with identical call signature.
-       *  @post @c (bool)*this == (bool)x
-       *  @returns @c *this
+       *  @brief Builds a %function whose target is constructed in place.
+       *  @param __args Arguments for the constructor of the target.
        *
-       *  The target of @a __x is copied to @c *this. If @a __x has no
-       *  target, then @c *this will be empty.
+       *  The target of type @a _Tp is constructed from @a __args directly
+       *  in the local buffer, or in its heap allocation if it does not fit,
+       *  without creating and moving a temporary.  Unlike the converting
+       *  constructor, the result is not empty even if the target is a null
+       *  pointer.
+       */
+      template<typename _Tp, typename... _Args,
+	       typename = _Requires<__and_<_Callable<_Tp>,
+					   is_constructible<_Tp, _Args...>>,
+				    void>>
+	explicit
+	basic_unique_function(in_place_type_t<_Tp>, _Args&&... __args)
+	{ _M_init_in_place<_Tp>(std::forward<_Args>(__args)...); }
+#endif
+
+      /**
+       *  @brief Builds a %function that targets the incoming function
+       *  object, using an allocator for any out-of-line storage.
+       *  @param __a An allocator used if the target does not fit locally.
+       *  @param __f A %function object callable with the wrapper's
+       *  signature.
        *
-       *  If @a __x targets a function pointer or a reference to a function
-       *  object, then this operation will not throw an %exception.
+       *  Targets that fit in the wrapper's local buffer are stored there
+       *  and @a __a is not used.  Otherwise a copy of @a __a allocates a
+       *  block holding both the target and the allocator, and the block
+       *  is returned to that allocator when the target is destroyed.
        */
-      unique_function&
-      operator=(const unique_function& __x)
-      {
-	unique_function(__x).swap(*this);
-	return *this;
-      }
+      template<typename _Functor, typename _Alloc,
+	       typename = _Requires<_Callable<_Functor>, void>>
+	basic_unique_function(allocator_arg_t, const _Alloc& __a, _Functor);
+
+      /**
+       *  @brief Destroys the target of @c *this, if it has one.
+       */
+      _GLIBCXX20_CONSTEXPR
+      ~basic_unique_function()
+      { _Function_base::_S_destroy(_M_vtable, _M_functor); }
+
+      basic_unique_function&
+      operator=(const basic_unique_function&) = delete;
 
       /**
        *  @brief %Function move-assignment operator.
        *  @param __x A %function rvalue with identical call signature.
        *  @returns @c *this
        *
-       *  The target of @a __x is moved to @c *this. If @a __x has no
-       *  target, then @c *this will be empty.
+       *  The target of @a __x is moved to @c *this and @a __x is left
+       *  empty. If @a __x has no target, then @c *this will be empty.
        *
-       *  If @a __x targets a function pointer or a reference to a function
-       *  object, then this operation will not throw an %exception.
+       *  This operation will not throw an %exception.
        */
-      unique_function&
-      operator=(unique_function&& __x)
+      basic_unique_function&
+      operator=(basic_unique_function&& __x) noexcept
       {
-	unique_function(std::move(__x)).swap(*this);
+	if (std::__addressof(__x) != this)
+	  {
+	    _Function_base::_S_destroy(_M_vtable, _M_functor);
+	    _Function_base::_S_move_target(_M_vtable, _M_functor,
+					   __x._M_vtable, __x._M_functor,
+					   &_S_empty_vtable);
+	  }
 	return *this;
       }
 
@@ -466,15 +1104,11 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
        *
        *  The target of @c *this is deallocated, leaving it empty.
        */
-      unique_function&
-      operator=(nullptr_t)
+      basic_unique_function&
+      operator=(nullptr_t) noexcept
       {
-	if (_M_manager)
-	  {
-	    _M_manager(_M_functor, _M_functor, __destroy_functor);
-	    _M_manager = 0;
-	    _M_invoker = 0;
-	  }
+	_Function_base::_S_destroy(_M_vtable, _M_functor);
+	_M_vtable = &_S_empty_vtable;
 	return *this;
       }
 
@@ -495,22 +1129,44 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
        *  reference_wrapper<F>, this function will not throw.
        */
       template<typename _Functor>
-	_Requires<_Callable<typename decay<_Functor>::type>, unique_function&>
+	_Requires<_Callable<typename decay<_Functor>::type>,
+		  basic_unique_function&>
 	operator=(_Functor&& __f)
 	{
-	  unique_function(std::forward<_Functor>(__f)).swap(*this);
+	  basic_unique_function(std::forward<_Functor>(__f)).swap(*this);
 	  return *this;
 	}
 
       /// @overload
       template<typename _Functor>
-	unique_function&
+	basic_unique_function&
 	operator=(reference_wrapper<_Functor> __f) noexcept
 	{
-	  unique_function(__f).swap(*this);
+	  basic_unique_function(__f).swap(*this);
 	  return *this;
 	}
 
+#if __cplusplus > 201402L
+      /**
+       *  @brief Replace the target with one constructed in place.
+       *  @param __args Arguments for the constructor of the target.
+       *  @return A reference to the new target.
+       *
+       *  The current target, if any, is destroyed first.  If constructing
+       *  the new target throws, @c *this is left empty.
+       */
+      template<typename _Tp, typename... _Args>
+	_Requires<__and_<_Callable<_Tp>, is_constructible<_Tp, _Args...>>,
+		  _Tp&>
+	emplace(_Args&&... __args)
+	{
+	  *this = nullptr;
+	  _M_init_in_place<_Tp>(std::forward<_Args>(__args)...);
+	  return *_Unique_Function_handler<_Signature, _Tp, _Function_base>::
+	    _M_get_target(_M_functor);
+	}
+#endif
+
       // [3.7.2.2] function modifiers
 
       /**
@@ -520,23 +1176,64 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
        *  Swap the targets of @c this function object and @a __f. This
        *  function will not throw an %exception.
        */
-      void swap(unique_function& __x)
+      void swap(basic_unique_function& __x) noexcept
+      {
+	_Function_base::_S_swap(_M_vtable, _M_functor, __x._M_vtable,
+				__x._M_functor, &_S_empty_vtable);
+      }
+
+      /**
+       *  @brief Determine if the target can be relocated by copying the
+       *  bytes of the wrapper.
+       *
+       *  @return @c true when this %function object is empty, owns a
+       *  heap-allocated target, or stores a target for which
+       *  @c __is_location_invariant holds; @c false otherwise.
+       *
+       *  This function will not throw an %exception.
+       */
+      bool
+      trivially_relocatable() const noexcept
+      { return !_M_vtable->_M_move; }
+
+      // Relocate __n wrappers from __first into the uninitialized storage
+      // at __result.  The whole range is copied bytewise and only targets
+      // that need a real move are fixed up afterwards.  The source objects
+      // must not be used or destroyed afterwards.
+      static basic_unique_function*
+      _S_relocate_n(basic_unique_function* __first, size_t __n,
+		    basic_unique_function* __result) noexcept
       {
-	std::swap(_M_functor, __x._M_functor);
-	std::swap(_M_manager, __x._M_manager);
-	std::swap(_M_invoker, __x._M_invoker);
+	if (__n == 0)
+	  return __result;
+	__builtin_memcpy(static_cast<void*>(__result),
+			 static_cast<const void*>(__first),
+			 __n * sizeof(basic_unique_function));
+	for (size_t __i = 0; __i < __n; ++__i)
+	  {
+	    _Function_base::_S_note_move(__first[__i]._M_vtable,
+					 __first[__i]._M_functor);
+	    if (__first[__i]._M_vtable->_M_move)
+	      __first[__i]._M_vtable->_M_move(__result[__i]._M_functor,
+					      __first[__i]._M_functor);
+	  }
+	return __result + __n;
       }
 
-      // TODO: needs allocator_arg_t
-      /*
+      /**
+       *  @brief %Function assignment to a new target, using an allocator
+       *  for any out-of-line storage.
+       *  @param __f A %function object callable with the wrapper's
+       *  signature.
+       *  @param __a An allocator used if the target does not fit locally.
+       */
       template<typename _Functor, typename _Alloc>
 	void
 	assign(_Functor&& __f, const _Alloc& __a)
 	{
-	  function(allocator_arg, __a,
-		   std::forward<_Functor>(__f)).swap(*this);
+	  basic_unique_function(allocator_arg, __a,
+				std::forward<_Functor>(__f)).swap(*this);
 	}
-      */
 
       // [3.7.2.3] function capacity
 
@@ -551,6 +1248,21 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
       explicit operator bool() const noexcept
       { return !_M_empty(); }
 
+      /**
+       *  @brief Determine if a target of type @a _Functor would be stored
+       *  in the local buffer rather than on the heap.
+       *
+       *  Usable in a constant expression, e.g.
+       *  @c static_assert(unique_function<void()>::stores_inline<F>()).
+       */
+      template<typename _Functor>
+	static constexpr bool
+	stores_inline() noexcept
+	{
+	  return _Function_base::template _Base_manager<
+	    typename decay<_Functor>::type>::__stored_locally;
+	}
+
       // [3.7.2.4] function invocation
 
       /**
@@ -559,9 +1271,23 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
        *  @throws bad_function_call when @c !(bool)*this
        *
        *  The function call operator invokes the target function object
-       *  stored by @c this.
+       *  stored by @c this.  An empty wrapper points at a vtable whose
+       *  invoker throws, so the call is a single indirect call with no
+       *  test for a target.  It carries the cv-qualifier, ref-qualifier
+       *  and exception specification of the signature.
        */
-      _Res operator()(_ArgTypes... __args) const;
+      using _Call::operator();
+
+      /**
+       *  @brief Invokes the function targeted by @c *this, which must
+       *  have a target.
+       *  @pre @c (bool)*this
+       *  @returns the result of the target.
+       *
+       *  For callers that have already established that the wrapper is
+       *  not empty.  Calling it on an empty wrapper is undefined.
+       */
+      using _Call::invoke_unchecked;
 
 #ifdef __GXX_RTTI
       // [3.7.2.5] function target access
@@ -575,13 +1301,18 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
        *  This function will not throw an %exception.
        */
       const type_info& target_type() const noexcept;
+#endif
 
       /**
        *  @brief Access the stored target function object.
        *
        *  @return Returns a pointer to the stored target function object,
-       *  if @c typeid(Functor).equals(target_type()); otherwise, a NULL
-       *  pointer.
+       *  if its type is @c Functor, ignoring cv-qualifiers; otherwise, a
+       *  NULL pointer.
+       *
+       *  The type is checked by comparing the address of a per-type tag
+       *  kept in the vtable, so this needs no RTTI and rejects any other
+       *  target type with a single comparison.
        *
        * This function will not throw an %exception.
        */
@@ -589,105 +1320,302 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
 
       /// @overload
       template<typename _Functor> const _Functor* target() const noexcept;
-#endif
 
     private:
-      typedef _Res (*_Invoker_type)(const _Any_data&, _ArgTypes...);
-      _Invoker_type _M_invoker;
-  };
+      template<typename>
+	friend class unique_function_ref;
 
-  // Out-of-line member definitions.
-  template<typename _Res, typename... _ArgTypes>
-    unique_function<_Res(_ArgTypes...)>::
-    unique_function(const unique_function& __x)
-    : _Unique_Function_base()
-    {
-      if (static_cast<bool>(__x))
+      template<typename, std::size_t, std::size_t>
+	friend class unique_function_batch;
+
+      template<std::size_t, std::size_t>
+	friend class unique_function_reclaimer;
+
+      // The address of the target, or null if there is none.
+      void*
+      _M_target_address() const noexcept
+      {
+	_Any_data __ptr;
+	__ptr.template _M_access<void*>() = nullptr;
+	_M_vtable->_M_manager(__ptr, _M_functor, __unique_get_functor_ptr);
+	return __ptr.template _M_access<void*>();
+      }
+
+      template<typename _Tp, typename... _Args>
+	void
+	_M_init_in_place(_Args&&... __args)
 	{
-	  _M_invoker = __x._M_invoker;
-	  _M_manager = __x._M_manager;
-	  __x._M_manager(_M_functor, __x._M_functor, __clone_functor);
+	  static_assert(is_same<_Tp, typename decay<_Tp>::type>::value,
+			"target type must not be a reference, array, "
+			"function or cv-qualified type");
+
+	  typedef _Unique_Function_handler<_Signature, _Tp,
+					  _Function_base> _My_handler;
+
+	  _My_handler::_M_init_functor(_M_functor,
+				       std::forward<_Args>(__args)...);
+	  _M_vtable = &_My_handler::_S_vtable;
 	}
-    }
 
-  template<typename _Res, typename... _ArgTypes>
+      template<typename _Functor, typename _Alloc>
+	void
+	_M_init_functor_alloc(_Functor&& __f, const _Alloc& __a, true_type);
+
+      template<typename _Functor, typename _Alloc>
+	void
+	_M_init_functor_alloc(_Functor&& __f, const _Alloc& __a, false_type);
+  };
+
+  // Out-of-line member definitions.
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
     template<typename _Functor, typename>
-      unique_function<_Res(_ArgTypes...)>::
-      unique_function(_Functor __f)
-      : _Unique_Function_base()
+      _GLIBCXX20_CONSTEXPR
+      basic_unique_function<_Signature, _Size, _Align>::
+      basic_unique_function(_Functor&& __f)
       {
-	typedef _Unique_Function_handler<_Signature_type, _Functor> _My_handler;
+	typedef typename decay<_Functor>::type _Tp;
+	typedef _Unique_Function_handler<_Signature, _Tp,
+					_Function_base> _My_handler;
 
 	if (_My_handler::_M_not_empty_function(__f))
 	  {
-	    _My_handler::_M_init_functor(_M_functor, std::move(__f));
-	    _M_invoker = &_My_handler::_M_invoke;
-	    _M_manager = &_My_handler::_M_manager;
+#if __cplusplus > 201703L
+	    // Placement new is not a constant expression, so a function
+	    // pointer is assigned to the union member it shares with the
+	    // buffer instead, and an empty trivially copyable target is not
+	    // written at all, as it has no state to read back.
+	    if (std::is_constant_evaluated()
+		&& (is_same<_Tp, typename _Call::_Function_ptr>::value
+		    || (is_empty<_Tp>::value
+			&& is_trivially_copyable<_Tp>::value)))
+	      {
+		if constexpr (is_same<_Tp,
+				      typename _Call::_Function_ptr>::value)
+		  _M_function_pointer = __f;
+	      }
+	    else
+#endif
+	    _My_handler::_M_init_functor(_M_functor,
+					 std::forward<_Functor>(__f));
+	    _M_vtable = &_My_handler::_S_vtable;
 	  }
       }
 
-  template<typename _Res, typename... _ArgTypes>
-    _Res
-    unique_function<_Res(_ArgTypes...)>::
-    operator()(_ArgTypes... __args) const
-    {
-      if (_M_empty())
-	__throw_bad_function_call();
-      return _M_invoker(_M_functor, std::forward<_ArgTypes>(__args)...);
-    }
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
+    template<typename _Functor, typename _Alloc, typename>
+      basic_unique_function<_Signature, _Size, _Align>::
+      basic_unique_function(allocator_arg_t, const _Alloc& __a, _Functor __f)
+      {
+	typedef _Unique_Function_handler<_Signature, _Functor,
+					_Function_base> _My_handler;
+
+	if (_My_handler::_M_not_empty_function(__f))
+	  _M_init_functor_alloc(std::move(__f), __a,
+				typename _My_handler::_Local_storage());
+      }
+
+  // A target that fits locally never needs the allocator.
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
+    template<typename _Functor, typename _Alloc>
+      void
+      basic_unique_function<_Signature, _Size, _Align>::
+      _M_init_functor_alloc(_Functor&& __f, const _Alloc&, true_type)
+      {
+	typedef _Unique_Function_handler<_Signature, _Functor,
+					_Function_base> _My_handler;
+
+	_My_handler::_M_init_functor(_M_functor, std::move(__f));
+	_M_vtable = &_My_handler::_S_vtable;
+      }
+
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
+    template<typename _Functor, typename _Alloc>
+      void
+      basic_unique_function<_Signature, _Size, _Align>::
+      _M_init_functor_alloc(_Functor&& __f, const _Alloc& __a, false_type)
+      {
+	typedef typename _Function_base::template
+	  _Alloc_manager<_Functor, _Alloc> _My_manager;
+	typedef _Unique_Function_handler<_Signature, _Functor,
+					_Function_base, _My_manager>
+	  _My_handler;
+
+	_My_handler::_M_init_functor(_M_functor, std::move(__f), __a);
+	_M_vtable = &_My_handler::_S_vtable;
+      }
 
 #ifdef __GXX_RTTI
-  template<typename _Res, typename... _ArgTypes>
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
     const type_info&
-    unique_function<_Res(_ArgTypes...)>::
+    basic_unique_function<_Signature, _Size, _Align>::
     target_type() const noexcept
     {
-      if (_M_manager)
+      if (!_M_empty())
 	{
 	  _Any_data __typeinfo_result;
-	  _M_manager(__typeinfo_result, _M_functor, __get_type_info);
-	  return *__typeinfo_result._M_access<const type_info*>();
+	  _M_vtable->_M_manager(__typeinfo_result, _M_functor,
+				__unique_get_type_info);
+	  return *__typeinfo_result.template _M_access<const type_info*>();
 	}
       else
 	return typeid(void);
     }
+#endif
 
-  template<typename _Res, typename... _ArgTypes>
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
     template<typename _Functor>
       _Functor*
-      unique_function<_Res(_ArgTypes...)>::
+      basic_unique_function<_Signature, _Size, _Align>::
       target() noexcept
       {
-	if (typeid(_Functor) == target_type() && _M_manager)
+	if (_M_vtable->_M_type
+	    == &_Unique_type_tag<typename remove_cv<_Functor>::type>::_S_id)
 	  {
 	    _Any_data __ptr;
-	    if (_M_manager(__ptr, _M_functor, __get_functor_ptr)
+	    if (_M_vtable->_M_manager(__ptr, _M_functor,
+				      __unique_get_functor_ptr)
 		&& !is_const<_Functor>::value)
 	      return 0;
 	    else
-	      return __ptr._M_access<_Functor*>();
+	      return __ptr.template _M_access<_Functor*>();
 	  }
 	else
 	  return 0;
       }
 
-  template<typename _Res, typename... _ArgTypes>
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
     template<typename _Functor>
       const _Functor*
-      unique_function<_Res(_ArgTypes...)>::
+      basic_unique_function<_Signature, _Size, _Align>::
       target() const noexcept
       {
-	if (typeid(_Functor) == target_type() && _M_manager)
+	if (_M_vtable->_M_type
+	    == &_Unique_type_tag<typename remove_cv<_Functor>::type>::_S_id)
 	  {
 	    _Any_data __ptr;
-	    _M_manager(__ptr, _M_functor, __get_functor_ptr);
-	    return __ptr._M_access<const _Functor*>();
+	    _M_vtable->_M_manager(__ptr, _M_functor, __unique_get_functor_ptr);
+	    return __ptr.template _M_access<const _Functor*>();
 	  }
 	else
 	  return 0;
       }
+
+  // Whether _Tp is a basic_unique_function of exactly _Signature.
+  template<typename _Tp, typename _Signature>
+    struct __is_basic_unique_function_of : false_type { };
+
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
+    struct __is_basic_unique_function_of<
+	basic_unique_function<_Signature, _Size, _Align>, _Signature>
+    : true_type { };
+
+  /**
+   *  @brief A non-owning reference to a callable object.
+   *  @ingroup functors
+   *
+   *  Holds the address of a callable and a pointer to a thunk that
+   *  invokes it, and never allocates.  It is meant for parameters that
+   *  are only called during the call that receives them; the referenced
+   *  callable must outlive the reference.
+   *
+   *  @a _Signature is @c R(A...), optionally followed by @c const and
+   *  (since C++17) @c noexcept.  As for basic_unique_function, the
+   *  callable is invoked as an lvalue with the cv-qualifier of the
+   *  signature applied.
+   *
+   *  A reference built from a basic_unique_function with the same
+   *  signature binds directly to the wrapper's current target, using
+   *  the thunk from the wrapper's vtable, so each call is a single
+   *  indirect call.  It becomes invalid when that wrapper is assigned,
+   *  moved from or destroyed.  A reference to an empty wrapper throws
+   *  bad_function_call when called.  A wrapper with any other signature
+   *  is referred to like any other callable object.
+   */
+#define _GLIBCXX_UNIQUE_FUNCTION_REF(_CV, _NOEXCEPT, _NE)		\
+  template<typename _Res, typename... _ArgTypes>			\
+    class unique_function_ref<_Res(_ArgTypes...) _CV _NOEXCEPT>	\
+    {									\
+      typedef _Unique_Function_invoker<_Res(_ArgTypes...), _NE> _Invoker; \
+									\
+      template<typename _Cond, typename _Tp>				\
+	using _Requires = typename enable_if<_Cond::value, _Tp>::type;	\
+									\
+      /* Callables bound by address: not a function, pointer to	\
+	 function or pointer to member, and not a wrapper of this	\
+	 signature, which is bound through its target instead.  */	\
+      template<typename _Functor,					\
+	       typename _Fn = typename remove_reference<_Functor>::type,	\
+	       typename _Obj = typename remove_cv<_Fn>::type>		\
+	using _Bindable							\
+	  = __and_<__not_<is_same<_Obj, unique_function_ref>>,		\
+		   __not_<is_function<_Obj>>,				\
+		   __not_<is_member_pointer<_Obj>>,			\
+		   __not_<__and_<is_pointer<_Obj>,				\
+				 is_function<typename remove_pointer<_Obj>::type>>>, \
+		   __not_<__is_basic_unique_function_of<			\
+			    _Obj, _Res(_ArgTypes...) _CV _NOEXCEPT>>,	\
+		   typename _Invoker::template _Is_callable<_Fn _CV&>>;	\
+									\
+    public:								\
+      typedef _Res result_type;						\
+									\
+      /** @brief Refers to the function @a __fn, which must not be null. */ \
+      template<typename _Fn,						\
+	       typename = _Requires<__and_<is_function<_Fn>,		\
+					   typename _Invoker::template	\
+					     _Is_callable<_Fn&>>, void>>	\
+	unique_function_ref(_Fn* __fn) noexcept				\
+	: _M_target(reinterpret_cast<void*>(__fn)),			\
+	  _M_invoke(&_Invoker::template _S_invoke_function<_Fn>)	\
+	{ __glibcxx_assert(__fn != nullptr); }				\
+									\
+      /** @brief Refers to the callable object @a __f.  */		\
+      template<typename _Functor,					\
+	       typename = _Requires<_Bindable<_Functor>, void>>		\
+	unique_function_ref(_Functor&& __f) noexcept			\
+	: _M_target(const_cast<void*>(					\
+		      static_cast<const void*>(std::__addressof(__f)))),	\
+	  _M_invoke(&_Invoker::template _S_invoke_target<		\
+		      typename remove_reference<_Functor>::type _CV&>)	\
+	{ }								\
+									\
+      /** @brief Refers to the current target of @a __f.  */		\
+      template<std::size_t _Size, std::size_t _Align>			\
+	unique_function_ref(						\
+	    _CV basic_unique_function<_Res(_ArgTypes...) _CV _NOEXCEPT,	\
+				      _Size, _Align>& __f) noexcept	\
+	: _M_target(__f._M_target_address()),				\
+	  _M_invoke(__f._M_vtable->_M_invoke_target)			\
+	{ }								\
+									\
+      /** @overload */						\
+      template<std::size_t _Size, std::size_t _Align>			\
+	unique_function_ref(						\
+	    basic_unique_function<_Res(_ArgTypes...) _CV _NOEXCEPT,	\
+				  _Size, _Align>&& __f) noexcept		\
+	: _M_target(__f._M_target_address()),				\
+	  _M_invoke(__f._M_vtable->_M_invoke_target)			\
+	{ }								\
+									\
+      /** @brief Invokes the referenced callable.  */			\
+      _Res								\
+      operator()(_ArgTypes... __args) const _NOEXCEPT			\
+      { return _M_invoke(_M_target, std::forward<_ArgTypes>(__args)...); } \
+									\
+    private:								\
+      void*						_M_target;	\
+      typename _Invoker::_Target_invoker_type		_M_invoke;	\
+    };
+
+_GLIBCXX_UNIQUE_FUNCTION_REF(     ,         , false)
+_GLIBCXX_UNIQUE_FUNCTION_REF(const,         , false)
+#if __cplusplus > 201402L
+_GLIBCXX_UNIQUE_FUNCTION_REF(     , noexcept, true)
+_GLIBCXX_UNIQUE_FUNCTION_REF(const, noexcept, true)
 #endif
 
+#undef _GLIBCXX_UNIQUE_FUNCTION_REF
+
   // [20.7.15.2.6] null pointer comparisons
 
   /**
@@ -697,15 +1625,18 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
    *
    *  This function will not throw an %exception.
    */
-  template<typename _Res, typename... _Args>
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
     inline bool
-    operator==(const unique_function<_Res(_Args...)>& __f, nullptr_t) noexcept
+    operator==(const basic_unique_function<_Signature, _Size, _Align>& __f,
+	       nullptr_t) noexcept
     { return !static_cast<bool>(__f); }
 
   /// @overload
-  template<typename _Res, typename... _Args>
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
     inline bool
-    operator==(nullptr_t, const unique_function<_Res(_Args...)>& __f) noexcept
+    operator==(nullptr_t,
+	       const basic_unique_function<_Signature, _Size, _Align>& __f)
+    noexcept
     { return !static_cast<bool>(__f); }
 
   /**
@@ -715,15 +1646,18 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
    *
    *  This function will not throw an %exception.
    */
-  template<typename _Res, typename... _Args>
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
     inline bool
-    operator!=(const unique_function<_Res(_Args...)>& __f, nullptr_t) noexcept
+    operator!=(const basic_unique_function<_Signature, _Size, _Align>& __f,
+	       nullptr_t) noexcept
     { return static_cast<bool>(__f); }
 
   /// @overload
-  template<typename _Res, typename... _Args>
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
     inline bool
-    operator!=(nullptr_t, const unique_function<_Res(_Args...)>& __f) noexcept
+    operator!=(nullptr_t,
+	       const basic_unique_function<_Signature, _Size, _Align>& __f)
+    noexcept
     { return static_cast<bool>(__f); }
 
   // [20.7.15.2.7] specialized algorithms
@@ -733,11 +1667,54 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
    *
    *  This function will not throw an %exception.
    */
-  template<typename _Res, typename... _Args>
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
     inline void
-    swap(unique_function<_Res(_Args...)>& __x, unique_function<_Res(_Args...)>& __y)
+    swap(basic_unique_function<_Signature, _Size, _Align>& __x,
+	 basic_unique_function<_Signature, _Size, _Align>& __y) noexcept
     { __x.swap(__y); }
 
+  /**
+   *  @brief Relocate a polymorphic function object wrapper.
+   *  @param __dest Uninitialized storage for the wrapper.
+   *  @param __src A wrapper whose lifetime ends on return.
+   *
+   *  Equivalent to move-constructing @c *__dest from @c *__src and then
+   *  destroying @c *__src.  This function will not throw an %exception.
+   */
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
+    inline void
+    relocate(basic_unique_function<_Signature, _Size, _Align>* __dest,
+	     basic_unique_function<_Signature, _Size, _Align>* __src)
+    noexcept
+    {
+      basic_unique_function<_Signature, _Size, _Align>::
+	_S_relocate_n(__src, 1, __dest);
+    }
+
+  /**
+   *  @brief Relocate a range of polymorphic function object wrappers.
+   *  @param __first The first of @a __n wrappers whose lifetimes end on
+   *  return.
+   *  @param __n The number of wrappers to relocate.
+   *  @param __result Uninitialized storage for @a __n wrappers.
+   *  @returns @c __result + @a __n
+   *
+   *  The range is copied with a single memcpy, after which only the
+   *  targets that are not trivially relocatable are moved individually.
+   *  This function will not throw an %exception.
+   */
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
+    inline basic_unique_function<_Signature, _Size, _Align>*
+    uninitialized_relocate_n(
+	basic_unique_function<_Signature, _Size, _Align>* __first,
+	size_t __n,
+	basic_unique_function<_Signature, _Size, _Align>* __result)
+    noexcept
+    {
+      return basic_unique_function<_Signature, _Size, _Align>::
+	_S_relocate_n(__first, __n, __result);
+    }
+
 _GLIBCXX_END_NAMESPACE_VERSION
 } // namespace std
 
@@ -0,0 +1,247 @@
+/*
+ * function_unique_batch.h
+ *
+ *  A set of basic_unique_function targets that are invoked together,
+ *  grouped by target type.
+ */
+
+#ifndef UNIQUE_FUNCTION_BATCH_H_
+#define UNIQUE_FUNCTION_BATCH_H_
+
+#pragma GCC system_header
+
+#include "function_unique.h"
+
+#if __cplusplus >= 201103L
+
+#include <bits/allocator.h>
+#include <bits/functexcept.h>
+#include <vector>
+
+namespace std _GLIBCXX_VISIBILITY(default)
+{
+_GLIBCXX_BEGIN_NAMESPACE_VERSION
+
+  /**
+   *  @brief A collection of callbacks that are all invoked at once.
+   *
+   *  Each inserted wrapper is taken apart into its vtable pointer and its
+   *  target storage.  Targets of the same type share a vtable, so they are
+   *  kept in one group: a single vtable pointer followed by a contiguous
+   *  array of target buffers.  invoke_all() walks each group in a tight
+   *  loop that makes the same indirect call every time, which the branch
+   *  predictor learns, and reads the targets sequentially.
+   *
+   *  Callbacks are invoked group by group, in the order in which each
+   *  group's first callback was inserted, and in insertion order within a
+   *  group.  Empty wrappers are not inserted.
+   */
+  template<typename _Signature,
+	   std::size_t _Size = sizeof(_Nocopy_types),
+	   std::size_t _Align = __alignof__(_Nocopy_types)>
+    class unique_function_batch
+    {
+      typedef _Unique_Function_base<_Size, _Align>		_Function_base;
+      typedef typename _Function_base::_Any_data		_Any_data;
+      typedef typename _Unique_Function_call<_Signature,
+					     _Function_base>::_Vtable _Vtable;
+
+    public:
+      typedef basic_unique_function<_Signature, _Size, _Align> value_type;
+      typedef std::size_t					size_type;
+
+      unique_function_batch() noexcept
+      : _M_size(0), _M_last(0) { }
+
+      unique_function_batch(unique_function_batch&& __x) noexcept
+      : _M_groups(std::move(__x._M_groups)), _M_size(__x._M_size),
+	_M_last(__x._M_last)
+      { __x._M_size = __x._M_last = 0; }
+
+      unique_function_batch(const unique_function_batch&) = delete;
+
+      unique_function_batch&
+      operator=(const unique_function_batch&) = delete;
+
+      unique_function_batch&
+      operator=(unique_function_batch&& __x) noexcept
+      {
+	unique_function_batch(std::move(__x)).swap(*this);
+	return *this;
+      }
+
+      ~unique_function_batch()
+      { clear(); }
+
+      /// The number of callbacks.
+      size_type
+      size() const noexcept
+      { return _M_size; }
+
+      bool
+      empty() const noexcept
+      { return _M_size == 0; }
+
+      /// The number of distinct target types.
+      size_type
+      group_count() const noexcept
+      { return _M_groups.size(); }
+
+      /**
+       *  @brief Add the target of @a __f, leaving @a __f empty.
+       *
+       *  Finding the group is a scan over the groups that starts with the
+       *  one used last, so runs of callbacks of one type are cheap.
+       */
+      void
+      insert(value_type&& __f)
+      {
+	if (!__f)
+	  return;
+	_Group& __g = _M_group_for(__f._M_vtable);
+	__g._M_reserve(__g._M_size + 1);
+	_Function_base::_S_relocate(__f._M_vtable, __g._M_data[__g._M_size],
+				    __f._M_functor);
+	__f._M_vtable = &value_type::_S_empty_vtable;
+	++__g._M_size;
+	++_M_size;
+      }
+
+      /// Add a callback constructed from @a __args.
+      template<typename... _Args>
+	void
+	emplace(_Args&&... __args)
+	{ insert(value_type(std::forward<_Args>(__args)...)); }
+
+      /**
+       *  @brief Invoke every callback with @a __args.
+       *
+       *  The arguments are passed to each callback as lvalues.  Results
+       *  are discarded.
+       */
+      template<typename... _Args>
+	void
+	invoke_all(_Args&&... __args)
+	{
+	  for (_Group& __g : _M_groups)
+	    {
+	      const auto __invoke = __g._M_vtable->_M_invoke;
+	      _Any_data* const __end = __g._M_data + __g._M_size;
+	      for (_Any_data* __p = __g._M_data; __p != __end; ++__p)
+		__invoke(*__p, __args...);
+	    }
+	}
+
+      /// Destroy every callback.
+      void
+      clear() noexcept
+      {
+	for (_Group& __g : _M_groups)
+	  __g._M_destroy();
+	_M_groups.clear();
+	_M_size = _M_last = 0;
+      }
+
+      void
+      swap(unique_function_batch& __x) noexcept
+      {
+	_M_groups.swap(__x._M_groups);
+	std::swap(_M_size, __x._M_size);
+	std::swap(_M_last, __x._M_last);
+      }
+
+    private:
+      // The targets of one type: a vtable and the buffers it applies to.
+      struct _Group
+      {
+	explicit
+	_Group(const _Vtable* __vtable) noexcept
+	: _M_vtable(__vtable), _M_data(), _M_size(0), _M_capacity(0) { }
+
+	_Group(_Group&& __g) noexcept
+	: _M_vtable(__g._M_vtable), _M_data(__g._M_data),
+	  _M_size(__g._M_size), _M_capacity(__g._M_capacity)
+	{
+	  __g._M_data = nullptr;
+	  __g._M_size = __g._M_capacity = 0;
+	}
+
+	_Group&
+	operator=(_Group&&) = delete;
+
+	~_Group()
+	{ _M_deallocate(); }
+
+	// Grow the buffer array, relocating the targets through the vtable.
+	void
+	_M_reserve(size_type __n)
+	{
+	  if (__n <= _M_capacity)
+	    return;
+	  size_type __cap = _M_capacity ? 2 * _M_capacity : 4;
+	  if (__cap < __n)
+	    __cap = __n;
+	  _Any_data* __data = allocator<_Any_data>().allocate(__cap);
+	  for (size_type __i = 0; __i < _M_size; ++__i)
+	    _Function_base::_S_relocate(_M_vtable, __data[__i], _M_data[__i]);
+	  _M_deallocate();
+	  _M_data = __data;
+	  _M_capacity = __cap;
+	}
+
+	void
+	_M_destroy() noexcept
+	{
+	  if (_M_vtable->_M_destroy)
+	    for (size_type __i = 0; __i < _M_size; ++__i)
+	      _M_vtable->_M_destroy(_M_data[__i]);
+	  _M_size = 0;
+	}
+
+	void
+	_M_deallocate() noexcept
+	{
+	  if (_M_data)
+	    allocator<_Any_data>().deallocate(_M_data, _M_capacity);
+	}
+
+	const _Vtable*	_M_vtable;
+	_Any_data*	_M_data;
+	size_type	_M_size;
+	size_type	_M_capacity;
+      };
+
+      _Group&
+      _M_group_for(const _Vtable* __vtable)
+      {
+	const size_type __n = _M_groups.size();
+	for (size_type __i = 0, __j = _M_last; __i < __n;
+	     ++__i, __j = (__j + 1 == __n ? 0 : __j + 1))
+	  if (_M_groups[__j]._M_vtable == __vtable)
+	    {
+	      _M_last = __j;
+	      return _M_groups[__j];
+	    }
+	_M_groups.emplace_back(__vtable);
+	_M_last = __n;
+	return _M_groups.back();
+      }
+
+      vector<_Group>	_M_groups;
+      size_type		_M_size;
+      size_type		_M_last;
+    };
+
+  /// Swap the contents of two unique_function_batch objects.
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
+    inline void
+    swap(unique_function_batch<_Signature, _Size, _Align>& __x,
+	 unique_function_batch<_Signature, _Size, _Align>& __y) noexcept
+    { __x.swap(__y); }
+
+_GLIBCXX_END_NAMESPACE_VERSION
+} // namespace std
+
+#endif // C++11
+
+#endif /* UNIQUE_FUNCTION_BATCH_H_ */
@@ -0,0 +1,167 @@
+/*
+ * function_unique_coroutine.h
+ *
+ *  Awaiting an operation that reports its completion through a
+ *  basic_unique_function callback.
+ */
+
+#ifndef UNIQUE_FUNCTION_COROUTINE_H_
+#define UNIQUE_FUNCTION_COROUTINE_H_
+
+#pragma GCC system_header
+
+#include "function_unique.h"
+
+#if __cplusplus > 201703L && __cpp_impl_coroutine
+
+#include <atomic>
+#include <coroutine>
+#include <optional>
+#include <tuple>
+
+namespace std _GLIBCXX_VISIBILITY(default)
+{
+_GLIBCXX_BEGIN_NAMESPACE_VERSION
+
+  // A coroutine handle is one trivially copyable pointer, so a wrapper
+  // keeps it in the local buffer and moves and destroys it without a
+  // call through the vtable.
+  static_assert(unique_function<void()>::stores_inline<coroutine_handle<>>(),
+		"a coroutine_handle is stored inline");
+
+  template<typename... _Args>
+    struct __unique_function_await_result
+    { typedef tuple<_Args...> type; };
+
+  template<typename _Arg>
+    struct __unique_function_await_result<_Arg>
+    { typedef _Arg type; };
+
+  template<>
+    struct __unique_function_await_result<>
+    { typedef void type; };
+
+  template<typename _Signature, typename _Initiate,
+	   std::size_t _Size = sizeof(_Nocopy_types),
+	   std::size_t _Align = __alignof__(_Nocopy_types)>
+    class unique_function_awaiter;
+
+  /**
+   *  @brief The awaitable returned by await_unique_function().
+   *
+   *  On suspension the coroutine's handle is kept in the awaiter, and the
+   *  initiating function is called with a callback that holds nothing but
+   *  a pointer to the awaiter.  That callback lives in the local buffer
+   *  of the basic_unique_function, so an await allocates nothing.  When
+   *  it is called, the callback stores its arguments in the awaiter and
+   *  resumes the coroutine, on whatever thread it was called.
+   *
+   *  If the callback is called before the initiating function returns,
+   *  the coroutine is not suspended at all.  co_await yields nothing for
+   *  a callback of no arguments, the argument itself, decayed, for one,
+   *  and a tuple of them for more.  The callback must be called exactly
+   *  once.
+   */
+  template<typename... _Args, typename _Initiate, std::size_t _Size,
+	   std::size_t _Align>
+    class unique_function_awaiter<void(_Args...), _Initiate, _Size, _Align>
+    {
+      typedef typename __unique_function_await_result<
+	typename decay<_Args>::type...>::type _Result;
+
+    public:
+      typedef basic_unique_function<void(_Args...), _Size, _Align>
+	callback_type;
+
+      explicit
+      unique_function_awaiter(_Initiate __init)
+      : _M_init(std::move(__init)), _M_ready(false) { }
+
+      unique_function_awaiter(const unique_function_awaiter&) = delete;
+
+      unique_function_awaiter&
+      operator=(const unique_function_awaiter&) = delete;
+
+      bool
+      await_ready() const noexcept
+      { return false; }
+
+      bool
+      await_suspend(coroutine_handle<> __h)
+      {
+	_M_handle = __h;
+	std::__invoke(std::move(_M_init), callback_type(_Callback{this}));
+	// Whoever gets here second resumes the coroutine: the callback if
+	// the operation is still pending, or else this function by
+	// declining to suspend.
+	return !_M_ready.exchange(true, memory_order_acq_rel);
+      }
+
+      _Result
+      await_resume()
+      { return _M_take(__bool_constant<sizeof...(_Args) == 1>()); }
+
+    private:
+      struct _Callback
+      {
+	void
+	operator()(_Args... __args) const
+	{
+	  unique_function_awaiter* __self = _M_self;
+	  __self->_M_values.emplace(std::forward<_Args>(__args)...);
+	  if (__self->_M_ready.exchange(true, memory_order_acq_rel))
+	    __self->_M_handle.resume();
+	}
+
+	unique_function_awaiter* _M_self;
+      };
+
+      _Result
+      _M_take(true_type)
+      { return std::get<0>(std::move(*_M_values)); }
+
+      _Result
+      _M_take(false_type)
+      { return _Result(std::move(*_M_values)); }
+
+      _Initiate					_M_init;
+      coroutine_handle<>			_M_handle;
+      optional<tuple<typename decay<_Args>::type...>> _M_values;
+      atomic<bool>				_M_ready;
+    };
+
+  /**
+   *  @brief Turn an operation that takes a completion callback into an
+   *  awaitable.
+   *  @param __init Called with the callback as
+   *  @c basic_unique_function<_Signature, _Size, _Align>, and expected to
+   *  start the operation.
+   *
+   *  For example, with
+   *  @c void @c async_read(buffer, unique_function<void(error_code, size_t)>)
+   *  @code
+   *    auto [ec, n] = co_await await_unique_function<void(error_code, size_t)>(
+   *	  [&](auto cb) { async_read(buf, std::move(cb)); });
+   *  @endcode
+   */
+  template<typename _Signature,
+	   std::size_t _Size = sizeof(_Nocopy_types),
+	   std::size_t _Align = __alignof__(_Nocopy_types),
+	   typename _Initiate>
+    inline unique_function_awaiter<_Signature,
+				   typename decay<_Initiate>::type,
+				   _Size, _Align>
+    await_unique_function(_Initiate&& __init)
+    {
+      return unique_function_awaiter<_Signature,
+				     typename decay<_Initiate>::type,
+				     _Size, _Align>(
+	  std::forward<_Initiate>(__init));
+    }
+
+_GLIBCXX_END_NAMESPACE_VERSION
+} // namespace std
+
+#endif // C++20
+
+#endif /* UNIQUE_FUNCTION_COROUTINE_H_ */
@@ -0,0 +1,156 @@
+/*
+ * function_unique_inplace.h
+ *
+ *  A move-only function wrapper that only ever stores its target in its
+ *  own buffer.
+ */
+
+#ifndef UNIQUE_FUNCTION_INPLACE_H_
+#define UNIQUE_FUNCTION_INPLACE_H_
+
+#pragma GCC system_header
+
+#include "function_unique.h"
+
+#if __cplusplus >= 201103L
+
+namespace std _GLIBCXX_VISIBILITY(default)
+{
+_GLIBCXX_BEGIN_NAMESPACE_VERSION
+
+  /**
+   *  @brief A basic_unique_function that never allocates.
+   *  @ingroup functors
+   *
+   *  Every target is kept in the local buffer of @a _Size bytes aligned
+   *  to @a _Align.  Storing a target that does not fit, or whose move
+   *  constructor may throw, is a compile-time error rather than a heap
+   *  allocation, so code on threads that must not allocate can hold
+   *  callbacks without checking each capture list by hand.  Move, swap
+   *  and destruction are noexcept and never allocate.
+   *
+   *  The wrapper is built on basic_unique_function and behaves like it
+   *  in every other respect, but it cannot be converted to one, and it
+   *  has no allocator-extended constructors.
+   */
+  template<typename _Signature,
+	   std::size_t _Size = sizeof(_Nocopy_types),
+	   std::size_t _Align = __alignof__(_Nocopy_types)>
+    class inplace_unique_function
+    : private basic_unique_function<_Signature, _Size, _Align>
+    {
+      typedef basic_unique_function<_Signature, _Size, _Align> _Base;
+
+      template<typename _Functor>
+	using _Convertible
+	  = __and_<__not_<is_same<typename decay<_Functor>::type,
+				  inplace_unique_function>>,
+		   is_constructible<_Base, _Functor>>;
+
+      template<typename _Cond, typename _Tp>
+	using _Requires = typename enable_if<_Cond::value, _Tp>::type;
+
+    public:
+      using typename _Base::result_type;
+
+      /**
+       *  @brief Default construct creates an empty function call wrapper.
+       *  @post @c !(bool)*this
+       */
+      inplace_unique_function() noexcept { }
+
+      /// @overload
+      inplace_unique_function(nullptr_t) noexcept { }
+
+      inplace_unique_function(inplace_unique_function&&) noexcept = default;
+
+      /**
+       *  @brief Builds a wrapper that targets @a __f.
+       *
+       *  Ill-formed unless the decayed type of @a __f fits the buffer and
+       *  is nothrow move constructible.
+       */
+      template<typename _Functor,
+	       typename = _Requires<_Convertible<_Functor>, void>>
+	inplace_unique_function(_Functor&& __f)
+	: _Base(std::forward<_Functor>(__f))
+	{
+	  static_assert(_Base::template stores_inline<_Functor>(),
+			"target must fit the inplace_unique_function buffer"
+			" and be nothrow move constructible");
+	}
+
+#if __cplusplus > 201402L
+      /// Builds a wrapper whose target is constructed in place.
+      template<typename _Tp, typename... _Args,
+	       typename = _Requires<is_constructible<_Base, in_place_type_t<_Tp>,
+						     _Args...>, void>>
+	explicit
+	inplace_unique_function(in_place_type_t<_Tp> __tag, _Args&&... __args)
+	: _Base(__tag, std::forward<_Args>(__args)...)
+	{
+	  static_assert(_Base::template stores_inline<_Tp>(),
+			"target must fit the inplace_unique_function buffer"
+			" and be nothrow move constructible");
+	}
+#endif
+
+      inplace_unique_function&
+      operator=(inplace_unique_function&&) noexcept = default;
+
+      inplace_unique_function&
+      operator=(nullptr_t) noexcept
+      {
+	_Base::operator=(nullptr);
+	return *this;
+      }
+
+      template<typename _Functor>
+	_Requires<_Convertible<_Functor>, inplace_unique_function&>
+	operator=(_Functor&& __f)
+	{
+	  inplace_unique_function(std::forward<_Functor>(__f)).swap(*this);
+	  return *this;
+	}
+
+#if __cplusplus > 201402L
+      /// Replace the target with one constructed in place.
+      template<typename _Tp, typename... _Args>
+	decltype(std::declval<_Base&>().template emplace<_Tp>(
+	    std::declval<_Args>()...))
+	emplace(_Args&&... __args)
+	{
+	  static_assert(_Base::template stores_inline<_Tp>(),
+			"target must fit the inplace_unique_function buffer"
+			" and be nothrow move constructible");
+	  return _Base::template emplace<_Tp>(std::forward<_Args>(__args)...);
+	}
+#endif
+
+      void
+      swap(inplace_unique_function& __x) noexcept
+      { _Base::swap(__x); }
+
+      using _Base::stores_inline;
+      using _Base::operator bool;
+      using _Base::operator();
+      using _Base::invoke_unchecked;
+      using _Base::target;
+#ifdef __GXX_RTTI
+      using _Base::target_type;
+#endif
+    };
+
+  /// Swap the targets of two inplace_unique_function objects.
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
+    inline void
+    swap(inplace_unique_function<_Signature, _Size, _Align>& __x,
+	 inplace_unique_function<_Signature, _Size, _Align>& __y) noexcept
+    { __x.swap(__y); }
+
+_GLIBCXX_END_NAMESPACE_VERSION
+} // namespace std
+
+#endif // C++11
+
+#endif /* UNIQUE_FUNCTION_INPLACE_H_ */
@@ -0,0 +1,393 @@
+/*
+ * function_unique_multi.h
+ *
+ *  A move-only function wrapper that erases one target behind several
+ *  call signatures.
+ */
+
+#ifndef UNIQUE_FUNCTION_MULTI_H_
+#define UNIQUE_FUNCTION_MULTI_H_
+
+#pragma GCC system_header
+
+#include "function_unique.h"
+
+#if __cplusplus >= 201103L
+
+namespace std _GLIBCXX_VISIBILITY(default)
+{
+_GLIBCXX_BEGIN_NAMESPACE_VERSION
+
+  template<std::size_t _Size, std::size_t _Align, typename... _Signatures>
+    class basic_unique_multi_function;
+
+  /**
+   *  @brief Polymorphic, move-only function wrapper with one call
+   *  operator per signature and the default inline capacity of
+   *  std::function.
+   */
+  template<typename... _Signatures>
+    using unique_multi_function
+      = basic_unique_multi_function<sizeof(_Nocopy_types),
+				    __alignof__(_Nocopy_types), _Signatures...>;
+
+  /**
+   *  The slot of a basic_unique_multi_function vtable for one signature,
+   *  with the thunks that fill it.  One partial specialization per
+   *  qualified signature, as for _Unique_Function_call.
+   */
+  template<typename _Signature, typename _Function_base>
+    struct _Unique_Multi_slot;
+
+  /**
+   *  The call operator of a basic_unique_multi_function for one
+   *  signature.  @a _Derived is the wrapper, which holds the storage and
+   *  the vtable pointer.
+   */
+  template<typename _Signature, typename _Function_base, typename _Derived>
+    class _Unique_Multi_call;
+
+#define _GLIBCXX_UNIQUE_MULTI_CALL2(_CV, _REF, _INV_REF, _NOEXCEPT, _NE)	\
+  template<typename _Res, typename... _ArgTypes, typename _Function_base> \
+    struct _Unique_Multi_slot<_Res(_ArgTypes...) _CV _REF _NOEXCEPT,	\
+			      _Function_base>				\
+    {									\
+      typedef typename _Function_base::_Any_data _Any_data;		\
+      typedef _Res (*_Invoker_type)(const _Any_data&, _ArgTypes...);	\
+      typedef _Unique_Function_invoker<_Res(_ArgTypes...), _NE> _Invoker; \
+									\
+      template<typename _Tp>						\
+	using _Target = _Tp _CV _INV_REF;				\
+									\
+      template<typename _Functor>					\
+	using _Is_callable						\
+	  = typename _Invoker::template _Is_callable<_Target<_Functor>>; \
+									\
+      template<typename _Handler, typename _Tp>				\
+	static _Res							\
+	_S_invoke(const _Any_data& __functor, _ArgTypes... __args)	\
+	noexcept(_NE)							\
+	{								\
+	  return std::__invoke_r<_Res>(					\
+	      static_cast<_Tp>(*_Handler::_M_get_target(__functor)),	\
+	      std::forward<_ArgTypes>(__args)...);			\
+	}								\
+									\
+      static _Res							\
+      _S_empty_invoke(const _Any_data&, _ArgTypes...)			\
+      { __throw_bad_function_call(); }					\
+									\
+      constexpr								\
+      _Unique_Multi_slot(_Invoker_type __invoke) noexcept		\
+      : _M_invoke(__invoke) { }						\
+									\
+      _Invoker_type _M_invoke;						\
+    };									\
+									\
+  template<typename _Res, typename... _ArgTypes, typename _Function_base, \
+	   typename _Derived>						\
+    class _Unique_Multi_call<_Res(_ArgTypes...) _CV _REF _NOEXCEPT,	\
+			     _Function_base, _Derived>			\
+    {									\
+      typedef _Unique_Multi_slot<_Res(_ArgTypes...) _CV _REF _NOEXCEPT, \
+				 _Function_base> _Slot;			\
+									\
+    public:								\
+      _Res								\
+      operator()(_ArgTypes... __args) _CV _REF _NOEXCEPT		\
+      {									\
+	const _Derived& __self = static_cast<const _Derived&>(*this);	\
+	return static_cast<const _Slot*>(__self._M_vtable)->_M_invoke(	\
+	    __self._M_functor, std::forward<_ArgTypes>(__args)...);	\
+      }									\
+    };
+
+#define _GLIBCXX_UNIQUE_MULTI_CALL(_NOEXCEPT, _NE)			\
+  _GLIBCXX_UNIQUE_MULTI_CALL2(     ,   , &,  _NOEXCEPT, _NE)		\
+  _GLIBCXX_UNIQUE_MULTI_CALL2(const,   , &,  _NOEXCEPT, _NE)		\
+  _GLIBCXX_UNIQUE_MULTI_CALL2(     , & , &,  _NOEXCEPT, _NE)		\
+  _GLIBCXX_UNIQUE_MULTI_CALL2(const, & , &,  _NOEXCEPT, _NE)		\
+  _GLIBCXX_UNIQUE_MULTI_CALL2(     , &&, &&, _NOEXCEPT, _NE)		\
+  _GLIBCXX_UNIQUE_MULTI_CALL2(const, &&, &&, _NOEXCEPT, _NE)
+
+_GLIBCXX_UNIQUE_MULTI_CALL(, false)
+#if __cplusplus > 201402L
+_GLIBCXX_UNIQUE_MULTI_CALL(noexcept, true)
+#endif
+
+#undef _GLIBCXX_UNIQUE_MULTI_CALL
+#undef _GLIBCXX_UNIQUE_MULTI_CALL2
+
+  // Brings the call operators of every signature into one scope.
+  template<typename _Function_base, typename _Derived,
+	   typename _Signature, typename... _Rest>
+    class _Unique_Multi_calls
+    : public _Unique_Multi_call<_Signature, _Function_base, _Derived>,
+      public _Unique_Multi_calls<_Function_base, _Derived, _Rest...>
+    {
+    public:
+      using _Unique_Multi_call<_Signature, _Function_base,
+			       _Derived>::operator();
+      using _Unique_Multi_calls<_Function_base, _Derived,
+				_Rest...>::operator();
+    };
+
+  template<typename _Function_base, typename _Derived, typename _Signature>
+    class _Unique_Multi_calls<_Function_base, _Derived, _Signature>
+    : public _Unique_Multi_call<_Signature, _Function_base, _Derived>
+    { };
+
+  /**
+   *  The vtable of a basic_unique_multi_function: the move, destroy and
+   *  manager operations of _Unique_Function_base::_Vtable plus one invoke
+   *  slot per signature, reached by converting to that slot's type.
+   */
+  template<typename _Function_base, typename... _Signatures>
+    struct _Unique_Multi_vtable
+    : _Unique_Multi_slot<_Signatures, _Function_base>...
+    {
+      typedef typename _Function_base::_Any_data	_Any_data;
+      typedef typename _Function_base::_Move_type	_Move_type;
+      typedef typename _Function_base::_Destroy_type	_Destroy_type;
+      typedef typename _Function_base::_Manager_type	_Manager_type;
+
+      constexpr
+      _Unique_Multi_vtable(_Move_type __move, _Destroy_type __destroy,
+			   _Manager_type __manager,
+			   typename _Unique_Multi_slot<_Signatures,
+				_Function_base>::_Invoker_type... __invoke)
+      noexcept
+      : _Unique_Multi_slot<_Signatures, _Function_base>(__invoke)...,
+	_M_move(__move), _M_destroy(__destroy), _M_manager(__manager) { }
+
+      _Move_type	_M_move;
+      _Destroy_type	_M_destroy;
+      _Manager_type	_M_manager;
+    };
+
+  template<typename _Functor, typename _Function_base,
+	   typename... _Signatures>
+    class _Unique_Multi_handler
+    : public _Function_base::template _Base_manager<_Functor>
+    {
+      typedef typename _Function_base::template _Base_manager<_Functor> _Base;
+      typedef typename _Function_base::_Any_data _Any_data;
+
+    public:
+      typedef _Unique_Multi_vtable<_Function_base, _Signatures...> _Vtable;
+
+      static _Functor*
+      _M_get_target(const _Any_data& __functor)
+      { return _Base::_M_get_pointer(__functor); }
+
+      static constexpr _Vtable _S_vtable{
+	_Function_base::template _S_move_op<_Base>(),
+	_Function_base::template _S_destroy_op<_Base>(),
+	&_Base::_M_manager,
+	&_Unique_Multi_slot<_Signatures, _Function_base>::template
+	  _S_invoke<_Unique_Multi_handler,
+		    typename _Unique_Multi_slot<_Signatures, _Function_base>::
+		      template _Target<_Functor>>... };
+    };
+
+#if __cplusplus < 201703L
+  template<typename _Functor, typename _Function_base,
+	   typename... _Signatures>
+    constexpr typename _Unique_Multi_handler<_Functor, _Function_base,
+					     _Signatures...>::_Vtable
+    _Unique_Multi_handler<_Functor, _Function_base, _Signatures...>::_S_vtable;
+#endif
+
+  // The vtable of a basic_unique_multi_function without a target.
+  template<typename _Function_base, typename... _Signatures>
+    struct _Unique_Multi_empty
+    {
+      typedef _Unique_Multi_vtable<_Function_base, _Signatures...> _Vtable;
+      typedef typename _Function_base::_Empty_manager _Empty_manager;
+
+      static constexpr _Vtable _S_vtable{
+	nullptr, nullptr, &_Empty_manager::_M_manager,
+	&_Unique_Multi_slot<_Signatures, _Function_base>::_S_empty_invoke... };
+    };
+
+#if __cplusplus < 201703L
+  template<typename _Function_base, typename... _Signatures>
+    constexpr typename _Unique_Multi_empty<_Function_base,
+					   _Signatures...>::_Vtable
+    _Unique_Multi_empty<_Function_base, _Signatures...>::_S_vtable;
+#endif
+
+  /**
+   *  @brief A polymorphic, move-only function wrapper with several call
+   *  signatures.
+   *  @ingroup functors
+   *
+   *  Holds a single target, which must be callable with every one of
+   *  @a _Signatures, and has one operator() per signature.  Storing a
+   *  set of related callbacks (say, data, error and close handlers
+   *  implemented by one object) this way needs one buffer, one vtable
+   *  pointer and at most one allocation, where separate
+   *  basic_unique_function objects would need one of each per signature.
+   *
+   *  Storage follows basic_unique_function: targets that are nothrow move
+   *  constructible and fit within @a _Size bytes aligned to @a _Align are
+   *  kept inline.  Each signature may carry the same qualifiers as the
+   *  signature of a basic_unique_function, and no two may be the same.
+   */
+  template<std::size_t _Size, std::size_t _Align, typename... _Signatures>
+    class basic_unique_multi_function
+    : public _Unique_Multi_calls<_Unique_Function_base<_Size, _Align>,
+				 basic_unique_multi_function<_Size, _Align,
+							     _Signatures...>,
+				 _Signatures...>,
+      private _Unique_Function_base<_Size, _Align>
+    {
+      static_assert(sizeof...(_Signatures) != 0,
+		    "basic_unique_multi_function needs a signature");
+
+      typedef _Unique_Function_base<_Size, _Align> _Function_base;
+      typedef typename _Function_base::_Any_data _Any_data;
+      typedef _Unique_Multi_vtable<_Function_base, _Signatures...> _Vtable;
+      typedef _Unique_Multi_empty<_Function_base, _Signatures...> _Empty;
+
+      template<typename, typename, typename>
+	friend class _Unique_Multi_call;
+
+      template<typename _Functor>
+	using _Callable
+	  = __and_<__not_<is_same<_Functor, basic_unique_multi_function>>,
+		   typename _Unique_Multi_slot<_Signatures, _Function_base>::
+		     template _Is_callable<_Functor>...>;
+
+      template<typename _Cond, typename _Tp>
+	using _Requires = typename enable_if<_Cond::value, _Tp>::type;
+
+    public:
+      /**
+       *  @brief Default construct creates an empty function call wrapper.
+       *  @post @c !(bool)*this
+       */
+      basic_unique_multi_function() noexcept
+      : _M_vtable(&_Empty::_S_vtable) { }
+
+      /// @overload
+      basic_unique_multi_function(nullptr_t) noexcept
+      : _M_vtable(&_Empty::_S_vtable) { }
+
+      basic_unique_multi_function(const basic_unique_multi_function&)
+	= delete;
+
+      /**
+       *  @brief Move constructor; @a __x is left empty.
+       */
+      basic_unique_multi_function(basic_unique_multi_function&& __x) noexcept
+      {
+	_Function_base::_S_move_target(_M_vtable, _M_functor, __x._M_vtable,
+				       __x._M_functor, &_Empty::_S_vtable);
+      }
+
+      /**
+       *  @brief Builds a wrapper that targets @a __f, which must be
+       *  callable with every signature.
+       *
+       *  A null function pointer or pointer to member gives an empty
+       *  wrapper.
+       */
+      template<typename _Functor,
+	       typename = _Requires<_Callable<typename decay<_Functor>::type>,
+				    void>>
+	basic_unique_multi_function(_Functor&& __f)
+	: _M_vtable(&_Empty::_S_vtable)
+	{
+	  typedef _Unique_Multi_handler<typename decay<_Functor>::type,
+					_Function_base, _Signatures...>
+	    _My_handler;
+
+	  if (_My_handler::_M_not_empty_function(__f))
+	    {
+	      _My_handler::_M_init_functor(_M_functor,
+					   std::forward<_Functor>(__f));
+	      _M_vtable = &_My_handler::_S_vtable;
+	    }
+	}
+
+      ~basic_unique_multi_function()
+      { _Function_base::_S_destroy(_M_vtable, _M_functor); }
+
+      basic_unique_multi_function&
+      operator=(const basic_unique_multi_function&) = delete;
+
+      basic_unique_multi_function&
+      operator=(basic_unique_multi_function&& __x) noexcept
+      {
+	if (std::__addressof(__x) != this)
+	  {
+	    _Function_base::_S_destroy(_M_vtable, _M_functor);
+	    _Function_base::_S_move_target(_M_vtable, _M_functor,
+					   __x._M_vtable, __x._M_functor,
+					   &_Empty::_S_vtable);
+	  }
+	return *this;
+      }
+
+      basic_unique_multi_function&
+      operator=(nullptr_t) noexcept
+      {
+	_Function_base::_S_destroy(_M_vtable, _M_functor);
+	_M_vtable = &_Empty::_S_vtable;
+	return *this;
+      }
+
+      template<typename _Functor>
+	_Requires<_Callable<typename decay<_Functor>::type>,
+		  basic_unique_multi_function&>
+	operator=(_Functor&& __f)
+	{
+	  basic_unique_multi_function(std::forward<_Functor>(__f)).swap(*this);
+	  return *this;
+	}
+
+      void
+      swap(basic_unique_multi_function& __x) noexcept
+      {
+	_Function_base::_S_swap(_M_vtable, _M_functor, __x._M_vtable,
+				__x._M_functor, &_Empty::_S_vtable);
+      }
+
+      /**
+       *  @brief Determine if the wrapper has a target.
+       */
+      explicit operator bool() const noexcept
+      { return !_M_empty(); }
+
+      /**
+       *  @brief Invokes the target with the signature that overload
+       *  resolution selects.
+       *  @throws bad_function_call when @c !(bool)*this
+       */
+      using _Unique_Multi_calls<_Function_base, basic_unique_multi_function,
+				_Signatures...>::operator();
+
+    private:
+      bool
+      _M_empty() const noexcept
+      { return _M_vtable == &_Empty::_S_vtable; }
+
+      _Any_data _M_functor;
+      const _Vtable* _M_vtable;
+    };
+
+  /// Swap the targets of two basic_unique_multi_function objects.
+  template<std::size_t _Size, std::size_t _Align, typename... _Signatures>
+    inline void
+    swap(basic_unique_multi_function<_Size, _Align, _Signatures...>& __x,
+	 basic_unique_multi_function<_Size, _Align, _Signatures...>& __y)
+    noexcept
+    { __x.swap(__y); }
+
+_GLIBCXX_END_NAMESPACE_VERSION
+} // namespace std
+
+#endif // C++11
+
+#endif /* UNIQUE_FUNCTION_MULTI_H_ */
@@ -0,0 +1,382 @@
+/*
+ * function_unique_pool.h
+ *
+ *  An allocator that serves the out-of-line targets of
+ *  basic_unique_function from per-thread size-class freelists.
+ */
+
+#ifndef UNIQUE_FUNCTION_POOL_H_
+#define UNIQUE_FUNCTION_POOL_H_
+
+#pragma GCC system_header
+
+#include "function_unique.h"
+
+#if __cplusplus >= 201103L
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+
+namespace std _GLIBCXX_VISIBILITY(default)
+{
+_GLIBCXX_BEGIN_NAMESPACE_VERSION
+
+  /**
+   *  The size classes of the allocators for out-of-line targets: powers
+   *  of two from 32 to 512 bytes, aligned for any fundamental type.
+   *  Requests that fit no class go to operator new, with their alignment.
+   */
+  struct _Unique_function_size_classes
+  {
+    static constexpr std::size_t _S_classes = 5;
+    static constexpr std::size_t _S_min_size = 32;
+
+    // The index of the smallest class holding __bytes aligned to __align,
+    // or _S_classes if no class can.
+    static std::size_t
+    _S_class(std::size_t __bytes, std::size_t __align) noexcept
+    {
+      if (__align > __alignof__(max_align_t))
+	return _S_classes;
+      std::size_t __c = 0;
+      for (std::size_t __size = _S_min_size; __size < __bytes; __size *= 2)
+	if (++__c == _S_classes)
+	  break;
+      return __c;
+    }
+
+    // Allocate a block that fits no class.
+    static void*
+    _S_allocate_unclassed(std::size_t __bytes, std::size_t __align)
+    {
+#if __cpp_aligned_new
+      if (__align > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+	return ::operator new(__bytes, align_val_t(__align));
+#endif
+      (void) __align;
+      return ::operator new(__bytes);
+    }
+
+    static void
+    _S_deallocate_unclassed(void* __p, std::size_t __bytes,
+			    std::size_t __align) noexcept
+    {
+#if __cpp_aligned_new
+      if (__align > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+	{
+# if __cpp_sized_deallocation
+	  ::operator delete(__p, __bytes, align_val_t(__align));
+# else
+	  ::operator delete(__p, align_val_t(__align));
+# endif
+	  return;
+	}
+#endif
+      (void) __align;
+#if __cpp_sized_deallocation
+      ::operator delete(__p, __bytes);
+#else
+      (void) __bytes;
+      ::operator delete(__p);
+#endif
+    }
+
+    // Without aligned operator new an over-aligned type cannot be
+    // allocated at all.
+    template<typename _Tp>
+      static constexpr bool
+      _S_allocatable()
+      {
+#if __cpp_aligned_new
+	return true;
+#else
+	return __alignof__(_Tp) <= __alignof__(max_align_t);
+#endif
+      }
+  };
+
+  /**
+   *  The freelists behind unique_function_pool_allocator.
+   *
+   *  Blocks come in size classes of 32, 64, 128, 256 and 512 bytes.  Each
+   *  thread keeps a freelist per class and allocates from it without
+   *  synchronization.  When a thread's list grows past two batches, one
+   *  batch of blocks is handed to a central list shared by all threads,
+   *  and a thread whose list is empty takes a whole batch back from it.
+   *  So a thread that only frees blocks allocated elsewhere, such as the
+   *  consumer of a task queue, returns them under one lock per batch.
+   *
+   *  Fresh blocks are carved a batch at a time from a single allocation.
+   *  Memory is kept for reuse and never returned to operator delete.
+   */
+  struct _Unique_function_pool : _Unique_function_size_classes
+  {
+    static constexpr std::size_t _S_batch = 32;
+
+    // A free block.  The first block of a batch also links the batches
+    // on the central list and records how many blocks follow it.
+    struct _Block
+    {
+      _Block*	  _M_next;
+      _Block*	  _M_next_batch;
+      std::size_t _M_count;
+    };
+
+    static_assert(sizeof(_Block) <= _S_min_size,
+		  "a free block must fit the smallest size class");
+
+    struct _Central
+    {
+      mutex   _M_mutex;
+      _Block* _M_batches[_S_classes] = { };
+    };
+
+    static _Central&
+    _S_central() noexcept
+    {
+      // Never destroyed, so threads exiting during static destruction
+      // can still return their blocks.
+      static _Central* __central = new _Central;
+      return *__central;
+    }
+
+    struct _Freelist
+    {
+      _Block*	  _M_head = nullptr;
+      std::size_t _M_count = 0;
+    };
+
+    struct _Thread_cache
+    {
+      _Freelist _M_lists[_S_classes];
+
+      ~_Thread_cache()
+      {
+	for (std::size_t __c = 0; __c < _S_classes; ++__c)
+	  while (_M_lists[__c]._M_count)
+	    _M_release_batch(__c);
+	_S_cache_destroyed() = true;
+      }
+
+      // Move up to one batch from the front of list __c to the central
+      // list.
+      void
+      _M_release_batch(std::size_t __c)
+      {
+	_Freelist& __list = _M_lists[__c];
+	_Block* __first = __list._M_head;
+	_Block* __last = __first;
+	std::size_t __n = 1;
+	while (__n < _S_batch && __last->_M_next)
+	  {
+	    __last = __last->_M_next;
+	    ++__n;
+	  }
+	__list._M_head = __last->_M_next;
+	__list._M_count -= __n;
+	__last->_M_next = nullptr;
+	__first->_M_count = __n;
+
+	_Central& __central = _S_central();
+	lock_guard<mutex> __lock(__central._M_mutex);
+	__first->_M_next_batch = __central._M_batches[__c];
+	__central._M_batches[__c] = __first;
+      }
+
+      // Refill the empty list __c from the central list, or else from a
+      // fresh allocation.
+      void
+      _M_acquire_batch(std::size_t __c)
+      {
+	_Freelist& __list = _M_lists[__c];
+	{
+	  _Central& __central = _S_central();
+	  lock_guard<mutex> __lock(__central._M_mutex);
+	  if (_Block* __batch = __central._M_batches[__c])
+	    {
+	      __central._M_batches[__c] = __batch->_M_next_batch;
+	      __list._M_head = __batch;
+	      __list._M_count = __batch->_M_count;
+	      return;
+	    }
+	}
+
+	const std::size_t __size = _S_min_size << __c;
+	char* __chunk = static_cast<char*>(::operator new(__size * _S_batch));
+	_Block* __head = nullptr;
+	for (std::size_t __i = _S_batch; __i-- > 0; )
+	  {
+	    _Block* __b = ::new (__chunk + __i * __size) _Block;
+	    __b->_M_next = __head;
+	    __head = __b;
+	  }
+	__list._M_head = __head;
+	__list._M_count = _S_batch;
+      }
+    };
+
+    // Set when the calling thread's cache has been destroyed at thread
+    // exit.  Trivially destructible, so it outlives the cache.
+    static bool&
+    _S_cache_destroyed() noexcept
+    {
+      static thread_local bool __destroyed = false;
+      return __destroyed;
+    }
+
+    // The calling thread's cache, or null once it has been destroyed.
+    static _Thread_cache*
+    _S_cache() noexcept
+    {
+      if (_S_cache_destroyed())
+	return nullptr;
+      static thread_local _Thread_cache __cache;
+      return &__cache;
+    }
+
+    static void*
+    _S_allocate(std::size_t __bytes, std::size_t __align)
+    {
+      const std::size_t __c = _S_class(__bytes, __align);
+      if (__c == _S_classes)
+	return _S_allocate_unclassed(__bytes, __align);
+
+      _Thread_cache* __cache = _S_cache();
+      if (!__cache)
+	return _S_central_allocate(__c);
+      _Freelist& __list = __cache->_M_lists[__c];
+      if (!__list._M_head)
+	__cache->_M_acquire_batch(__c);
+      _Block* __b = __list._M_head;
+      __list._M_head = __b->_M_next;
+      --__list._M_count;
+      return __b;
+    }
+
+    static void
+    _S_deallocate(void* __p, std::size_t __bytes, std::size_t __align)
+    noexcept
+    {
+      const std::size_t __c = _S_class(__bytes, __align);
+      if (__c == _S_classes)
+	{
+	  _S_deallocate_unclassed(__p, __bytes, __align);
+	  return;
+	}
+
+      _Block* __b = ::new (__p) _Block;
+      _Thread_cache* __cache = _S_cache();
+      if (!__cache)
+	{
+	  _S_central_deallocate(__c, __b);
+	  return;
+	}
+      _Freelist& __list = __cache->_M_lists[__c];
+      __b->_M_next = __list._M_head;
+      __list._M_head = __b;
+      if (++__list._M_count > 2 * _S_batch)
+	__cache->_M_release_batch(__c);
+    }
+
+    // Take one block of class __c straight from the central list, for a
+    // thread whose cache is gone.
+    static void*
+    _S_central_allocate(std::size_t __c)
+    {
+      {
+	_Central& __central = _S_central();
+	lock_guard<mutex> __lock(__central._M_mutex);
+	if (_Block* __batch = __central._M_batches[__c])
+	  {
+	    __central._M_batches[__c] = __batch->_M_next_batch;
+	    if (_Block* __rest = __batch->_M_next)
+	      {
+		__rest->_M_count = __batch->_M_count - 1;
+		__rest->_M_next_batch = __central._M_batches[__c];
+		__central._M_batches[__c] = __rest;
+	      }
+	    return __batch;
+	  }
+      }
+      return ::operator new(_S_min_size << __c);
+    }
+
+    // Return one block of class __c to the central list as a batch of
+    // its own, for a thread whose cache is gone.
+    static void
+    _S_central_deallocate(std::size_t __c, _Block* __b) noexcept
+    {
+      __b->_M_next = nullptr;
+      __b->_M_count = 1;
+      _Central& __central = _S_central();
+      lock_guard<mutex> __lock(__central._M_mutex);
+      __b->_M_next_batch = __central._M_batches[__c];
+      __central._M_batches[__c] = __b;
+    }
+  };
+
+  /**
+   *  @brief An allocator for the out-of-line targets of
+   *  basic_unique_function that recycles blocks through per-thread
+   *  size-class freelists.
+   *
+   *  Pass it with allocator_arg to the constructor of basic_unique_function
+   *  or to assign().  Requests of up to 512 bytes are rounded up to a
+   *  power of two of at least 32 bytes and served from the freelist of
+   *  the calling thread; larger or over-aligned requests go to operator
+   *  new, which is passed the alignment.  The allocator is stateless, so
+   *  every instance can free memory allocated by any other, on any
+   *  thread.
+   */
+  template<typename _Tp>
+    struct unique_function_pool_allocator
+    {
+      typedef _Tp	value_type;
+      typedef true_type	propagate_on_container_move_assignment;
+      typedef true_type	is_always_equal;
+
+      unique_function_pool_allocator() noexcept { }
+
+      template<typename _Up>
+	unique_function_pool_allocator(
+	    const unique_function_pool_allocator<_Up>&) noexcept { }
+
+      _Tp*
+      allocate(std::size_t __n)
+      {
+	static_assert(_Unique_function_pool::_S_allocatable<_Tp>(),
+		      "over-aligned types need aligned operator new");
+	if (__n > std::size_t(-1) / sizeof(_Tp))
+	  __throw_bad_alloc();
+	return static_cast<_Tp*>(
+	    _Unique_function_pool::_S_allocate(__n * sizeof(_Tp),
+					       __alignof__(_Tp)));
+      }
+
+      void
+      deallocate(_Tp* __p, std::size_t __n) noexcept
+      {
+	_Unique_function_pool::_S_deallocate(__p, __n * sizeof(_Tp),
+					     __alignof__(_Tp));
+      }
+    };
+
+  template<typename _Tp, typename _Up>
+    inline bool
+    operator==(const unique_function_pool_allocator<_Tp>&,
+	       const unique_function_pool_allocator<_Up>&) noexcept
+    { return true; }
+
+  template<typename _Tp, typename _Up>
+    inline bool
+    operator!=(const unique_function_pool_allocator<_Tp>&,
+	       const unique_function_pool_allocator<_Up>&) noexcept
+    { return false; }
+
+_GLIBCXX_END_NAMESPACE_VERSION
+} // namespace std
+
+#endif // C++11
+
+#endif /* UNIQUE_FUNCTION_POOL_H_ */
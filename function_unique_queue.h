@@ -0,0 +1,331 @@
+/*
+ * function_unique_queue.h
+ *
+ *  A bounded, lock-free multi-producer/single-consumer queue of
+ *  basic_unique_function.
+ */
+
+#ifndef UNIQUE_FUNCTION_QUEUE_H_
+#define UNIQUE_FUNCTION_QUEUE_H_
+
+#pragma GCC system_header
+
+#include "function_unique.h"
+
+#if __cplusplus >= 201103L
+
+#include <atomic>
+#include <bits/functexcept.h>
+
+namespace std _GLIBCXX_VISIBILITY(default)
+{
+_GLIBCXX_BEGIN_NAMESPACE_VERSION
+
+  /**
+   *  The slots and producer side of a bounded multi-producer ring buffer,
+   *  shared by unique_function_queue and unique_function_reclaimer.
+   *
+   *  Each slot carries a sequence number as in Vyukov's bounded queue: it
+   *  equals the slot's position when the slot is free for that position,
+   *  and the position plus one once it has been published.  Producers
+   *  claim positions with a compare-and-swap on the tail; the position of
+   *  the consumer, and how consumers are serialized, is up to the owner.
+   *  @a _Slot must have an @c atomic<size_t> member @c _M_seq.
+   */
+  template<typename _Slot>
+    class _Unique_function_ring
+    {
+    public:
+      typedef std::size_t size_type;
+
+      // Create a ring with room for at least __n slots, rounded up to a
+      // power of two.  __what names the owner in a length_error.
+      _Unique_function_ring(size_type __n, const char* __what)
+      : _M_mask(_S_round_up(__n, __what) - 1),
+	_M_slots(new _Slot[_M_mask + 1]), _M_tail(0)
+      {
+	for (size_type __i = 0; __i <= _M_mask; ++__i)
+	  _M_slots[__i]._M_seq.store(__i, memory_order_relaxed);
+      }
+
+      _Unique_function_ring(const _Unique_function_ring&) = delete;
+
+      _Unique_function_ring&
+      operator=(const _Unique_function_ring&) = delete;
+
+      ~_Unique_function_ring()
+      { delete[] _M_slots; }
+
+      size_type
+      _M_capacity() const noexcept
+      { return _M_mask + 1; }
+
+      // Claim the slot for the next push and store its position in __pos,
+      // or return null if the ring is full.
+      _Slot*
+      _M_claim(size_type& __pos) noexcept
+      {
+	__pos = _M_tail.load(memory_order_relaxed);
+	for (;;)
+	  {
+	    _Slot* __slot = &_M_slot(__pos);
+	    const size_type __seq = __slot->_M_seq.load(memory_order_acquire);
+	    const ptrdiff_t __diff = ptrdiff_t(__seq - __pos);
+	    if (__diff == 0)
+	      {
+		if (_M_tail.compare_exchange_weak(__pos, __pos + 1,
+						  memory_order_relaxed))
+		  return __slot;
+	      }
+	    else if (__diff < 0)
+	      return nullptr;
+	    else
+	      __pos = _M_tail.load(memory_order_relaxed);
+	  }
+      }
+
+      // Make the slot claimed at __pos visible to the consumer.
+      void
+      _M_publish(_Slot& __slot, size_type __pos) noexcept
+      { __slot._M_seq.store(__pos + 1, memory_order_release); }
+
+      // The slot at __head if it has been published, else null.
+      _Slot*
+      _M_ready(size_type __head) const noexcept
+      {
+	_Slot& __slot = _M_slot(__head);
+	if (__slot._M_seq.load(memory_order_acquire) != __head + 1)
+	  return nullptr;
+	return &__slot;
+      }
+
+      // Free the slot at __head for the push one lap later.
+      void
+      _M_free(_Slot& __slot, size_type __head) noexcept
+      { __slot._M_seq.store(__head + _M_mask + 1, memory_order_release); }
+
+    private:
+      static size_type
+      _S_round_up(size_type __n, const char* __what)
+      {
+	size_type __cap = 2;
+	while (__cap < __n)
+	  {
+	    if (__cap > size_type(-1) / 2)
+	      __throw_length_error(__what);
+	    __cap *= 2;
+	  }
+	return __cap;
+      }
+
+      _Slot&
+      _M_slot(size_type __pos) const noexcept
+      { return _M_slots[__pos & _M_mask]; }
+
+      const size_type		_M_mask;
+      _Slot* const		_M_slots;
+      // Written by producers, apart from the consumer's position.
+      alignas(64) atomic<size_type> _M_tail;
+    };
+
+  /**
+   *  @brief A bounded queue of polymorphic function object wrappers that
+   *  any number of threads may push to and one thread pops from.
+   *
+   *  Every slot of the ring buffer holds the storage for one wrapper.  A
+   *  push claims a slot with a single compare-and-swap and constructs the
+   *  wrapper there directly from the pushed callable; a pop invokes the
+   *  wrapper in its slot and destroys it.  A target that fits the local
+   *  buffer is therefore never moved or allocated between the producer
+   *  and the call.
+   *
+   *  The slots are sequenced as in Vyukov's bounded queue; see
+   *  _Unique_function_ring.
+   */
+  template<typename _Signature,
+	   std::size_t _Size = sizeof(_Nocopy_types),
+	   std::size_t _Align = __alignof__(_Nocopy_types)>
+    class unique_function_queue
+    {
+    public:
+      typedef basic_unique_function<_Signature, _Size, _Align> value_type;
+      typedef std::size_t					size_type;
+
+      /**
+       *  @brief Create a queue with room for at least @a __n wrappers.
+       *
+       *  The capacity is rounded up to a power of two.
+       */
+      explicit
+      unique_function_queue(size_type __n)
+      : _M_ring(__n, __N("unique_function_queue")), _M_head(0)
+      { }
+
+      unique_function_queue(const unique_function_queue&) = delete;
+
+      unique_function_queue&
+      operator=(const unique_function_queue&) = delete;
+
+      /// Destroys the wrappers that were pushed but not popped.
+      ~unique_function_queue()
+      {
+	while (_Slot* __slot = _M_ring._M_ready(_M_head))
+	  _M_release(*__slot);
+      }
+
+      size_type
+      capacity() const noexcept
+      { return _M_ring._M_capacity(); }
+
+      /**
+       *  @brief Push a wrapper constructed from @a __args.
+       *  @return @c false, without constructing anything, if the queue is
+       *  full.
+       *
+       *  May be called from any number of threads at once.  If the
+       *  constructor of the wrapper throws, the claimed slot is published
+       *  empty and skipped by the consumer, and the exception propagates.
+       */
+      template<typename... _Args>
+	bool
+	try_push(_Args&&... __args)
+	{
+	  size_type __pos;
+	  _Slot* __slot = _M_ring._M_claim(__pos);
+	  if (!__slot)
+	    return false;
+
+	  __try
+	    {
+	      ::new (__slot->_M_addr()) value_type(std::forward<_Args>(__args)...);
+	    }
+	  __catch(...)
+	    {
+	      ::new (__slot->_M_addr()) value_type();
+	      _M_ring._M_publish(*__slot, __pos);
+	      __throw_exception_again;
+	    }
+	  _M_ring._M_publish(*__slot, __pos);
+	  return true;
+	}
+
+#if __cplusplus > 201402L
+      /**
+       *  @brief Push a wrapper whose target of type @a _Tp is constructed
+       *  in the slot from @a __args.
+       *  @return @c false if the queue is full.
+       */
+      template<typename _Tp, typename... _Args>
+	bool
+	try_emplace(_Args&&... __args)
+	{ return try_push(in_place_type<_Tp>, std::forward<_Args>(__args)...); }
+#endif
+
+      /**
+       *  @brief Invoke and destroy the oldest wrapper.
+       *  @param __args Arguments for the wrapper.
+       *  @return @c false if the queue was empty.
+       *
+       *  Must only be called by the consumer thread.  The wrapper is
+       *  invoked with the qualifiers of its signature, so as an rvalue
+       *  for a @c R(A...) @c && signature, and is destroyed and its slot
+       *  freed even if the invocation throws.
+       */
+      template<typename... _Args>
+	bool
+	try_invoke(_Args&&... __args)
+	{
+	  for (;;)
+	    {
+	      _Slot* __slot = _M_ring._M_ready(_M_head);
+	      if (!__slot)
+		return false;
+	      _Release_guard __guard{this, *__slot};
+	      value_type& __f = *__slot->_M_ptr();
+	      if (__f)
+		{
+		  static_cast<_Call_type>(__f)(std::forward<_Args>(__args)...);
+		  return true;
+		}
+	    }
+	}
+
+      /**
+       *  @brief Move the oldest wrapper into @a __f.
+       *  @return @c false, leaving @a __f unchanged, if the queue was empty.
+       *
+       *  Must only be called by the consumer thread.
+       */
+      bool
+      try_pop(value_type& __f) noexcept
+      {
+	for (;;)
+	  {
+	    _Slot* __slot = _M_ring._M_ready(_M_head);
+	    if (!__slot)
+	      return false;
+	    value_type& __v = *__slot->_M_ptr();
+	    const bool __found = static_cast<bool>(__v);
+	    if (__found)
+	      __f = std::move(__v);
+	    _M_release(*__slot);
+	    if (__found)
+	      return true;
+	  }
+      }
+
+      /**
+       *  @brief Determine if the queue has nothing to pop.
+       *
+       *  Must only be called by the consumer thread.
+       */
+      bool
+      empty() const noexcept
+      { return !_M_ring._M_ready(_M_head); }
+
+    private:
+      // The wrapper with the qualifiers of _Signature, as invoked.
+      typedef typename value_type::template _Target<value_type> _Call_type;
+
+      struct _Slot
+      {
+	value_type*
+	_M_ptr() noexcept
+	{ return static_cast<value_type*>(_M_addr()); }
+
+	void*
+	_M_addr() noexcept
+	{ return static_cast<void*>(&_M_storage[0]); }
+
+	atomic<size_type> _M_seq;
+	alignas(value_type) unsigned char _M_storage[sizeof(value_type)];
+      };
+
+      // Destroys the wrapper at the head and frees its slot on scope exit.
+      struct _Release_guard
+      {
+	~_Release_guard() { _M_queue->_M_release(_M_slot); }
+
+	unique_function_queue* _M_queue;
+	_Slot& _M_slot;
+      };
+
+      void
+      _M_release(_Slot& __slot) noexcept
+      {
+	__slot._M_ptr()->~value_type();
+	_M_ring._M_free(__slot, _M_head);
+	++_M_head;
+      }
+
+      _Unique_function_ring<_Slot> _M_ring;
+      // Written by the consumer only, away from the producers' tail.
+      alignas(64) size_type	_M_head;
+    };
+
+_GLIBCXX_END_NAMESPACE_VERSION
+} // namespace std
+
+#endif // C++11
+
+#endif /* UNIQUE_FUNCTION_QUEUE_H_ */
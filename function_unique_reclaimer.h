@@ -0,0 +1,208 @@
+/*
+ * function_unique_reclaimer.h
+ *
+ *  Destroys the targets of basic_unique_function objects on a background
+ *  thread.
+ */
+
+#ifndef UNIQUE_FUNCTION_RECLAIMER_H_
+#define UNIQUE_FUNCTION_RECLAIMER_H_
+
+#pragma GCC system_header
+
+#include "function_unique.h"
+#include "function_unique_queue.h"
+
+#if __cplusplus >= 201103L
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace std _GLIBCXX_VISIBILITY(default)
+{
+_GLIBCXX_BEGIN_NAMESPACE_VERSION
+
+  /**
+   *  @brief A bounded queue of targets waiting to be destroyed away from
+   *  the threads that released them.
+   *
+   *  defer_destroy() takes the target out of a wrapper and queues it with
+   *  the destroy operation from the wrapper's vtable.  For a target on the
+   *  heap that is a copy of one pointer, so a latency-sensitive thread
+   *  does not run the destructor of a large closure, or the deallocation,
+   *  itself.  Targets of any signature may be queued, as long as the
+   *  wrappers share @a _Size and @a _Align.
+   *
+   *  The queue is the bounded multi-producer ring of
+   *  unique_function_queue.  Unless constructed with a zero interval, the
+   *  reclaimer runs a thread that empties it at that interval, and
+   *  straight away once it is half full.  drain() empties it on the
+   *  calling thread, and the destructor stops the thread and drains what
+   *  is left.
+   */
+  template<std::size_t _Size = sizeof(_Nocopy_types),
+	   std::size_t _Align = __alignof__(_Nocopy_types)>
+    class unique_function_reclaimer
+    {
+      typedef _Unique_Function_base<_Size, _Align>	_Function_base;
+      typedef typename _Function_base::_Any_data	_Any_data;
+      typedef typename _Function_base::_Destroy_type	_Destroy_type;
+
+    public:
+      typedef std::size_t				size_type;
+
+      /**
+       *  @brief Create a reclaimer with room for at least @a __n targets.
+       *  @param __interval How often the background thread drains the
+       *  queue, or zero for no background thread.
+       *
+       *  The capacity is rounded up to a power of two.
+       */
+      explicit
+      unique_function_reclaimer(size_type __n = 1024,
+				chrono::milliseconds __interval
+				  = chrono::milliseconds(1))
+      : _M_ring(__n, __N("unique_function_reclaimer")),
+	_M_interval(__interval), _M_stop(false), _M_head(0)
+      {
+	if (_M_interval.count() > 0)
+	  _M_thread = thread(&unique_function_reclaimer::_M_run, this);
+      }
+
+      unique_function_reclaimer(const unique_function_reclaimer&) = delete;
+
+      unique_function_reclaimer&
+      operator=(const unique_function_reclaimer&) = delete;
+
+      /// Stops the background thread and destroys every queued target.
+      ~unique_function_reclaimer()
+      {
+	if (_M_thread.joinable())
+	  {
+	    {
+	      lock_guard<mutex> __lock(_M_wake_mutex);
+	      _M_stop = true;
+	    }
+	    _M_wake.notify_one();
+	    _M_thread.join();
+	  }
+	drain();
+      }
+
+      size_type
+      capacity() const noexcept
+      { return _M_ring._M_capacity(); }
+
+      /**
+       *  @brief Queue the target of @a __f for destruction and leave
+       *  @a __f empty.
+       *  @return @c false if the queue was full, in which case the target
+       *  was destroyed by this call instead.
+       *
+       *  May be called from any number of threads at once.  Targets that
+       *  need no destruction, such as function pointers, are not queued.
+       */
+      template<typename _Signature>
+	bool
+	defer_destroy(basic_unique_function<_Signature, _Size, _Align>&& __f)
+	noexcept
+	{
+	  typedef basic_unique_function<_Signature, _Size, _Align> _Function;
+
+	  const auto __vtable = __f._M_vtable;
+	  if (!__vtable->_M_destroy)
+	    {
+	      __f._M_vtable = &_Function::_S_empty_vtable;
+	      return true;
+	    }
+
+	  size_type __pos;
+	  _Slot* __slot = _M_ring._M_claim(__pos);
+	  if (!__slot)
+	    {
+	      __f = nullptr;
+	      return false;
+	    }
+
+	  _Function_base::_S_relocate(__vtable, __slot->_M_data,
+				      __f._M_functor);
+	  __slot->_M_destroy = __vtable->_M_destroy;
+	  __f._M_vtable = &_Function::_S_empty_vtable;
+	  _M_ring._M_publish(*__slot, __pos);
+
+	  // Wake the background thread early when the queue reaches half
+	  // its capacity, rather than on every push.
+	  if (__pos - _M_head.load(memory_order_relaxed) == capacity() / 2)
+	    _M_wake.notify_one();
+	  return true;
+	}
+
+      /**
+       *  @brief Destroy every queued target on the calling thread.
+       *  @return The number of targets destroyed.
+       *
+       *  May be called from any thread, including while the background
+       *  thread runs.  For shutdown, call it after the last
+       *  defer_destroy() to know that every target has been destroyed.
+       */
+      size_type
+      drain() noexcept
+      {
+	lock_guard<mutex> __lock(_M_drain_mutex);
+	size_type __n = 0;
+	for (;;)
+	  {
+	    const size_type __head = _M_head.load(memory_order_relaxed);
+	    _Slot* __slot = _M_ring._M_ready(__head);
+	    if (!__slot)
+	      return __n;
+	    __slot->_M_destroy(__slot->_M_data);
+	    _M_ring._M_free(*__slot, __head);
+	    _M_head.store(__head + 1, memory_order_relaxed);
+	    ++__n;
+	  }
+      }
+
+    private:
+      struct _Slot
+      {
+	atomic<size_type>	_M_seq;
+	_Destroy_type		_M_destroy;
+	_Any_data		_M_data;
+      };
+
+      void
+      _M_run()
+      {
+	unique_lock<mutex> __lock(_M_wake_mutex);
+	while (!_M_stop)
+	  {
+	    __lock.unlock();
+	    drain();
+	    __lock.lock();
+	    if (!_M_stop)
+	      _M_wake.wait_for(__lock, _M_interval);
+	  }
+      }
+
+      _Unique_function_ring<_Slot> _M_ring;
+      const chrono::milliseconds _M_interval;
+      thread			_M_thread;
+      mutex			_M_wake_mutex;
+      condition_variable	_M_wake;
+      bool			_M_stop;
+      // Serializes consumers: the background thread and drain() callers.
+      mutex			_M_drain_mutex;
+      // Written by consumers, away from the producers' tail in _M_ring.
+      alignas(64) atomic<size_type> _M_head;
+    };
+
+_GLIBCXX_END_NAMESPACE_VERSION
+} // namespace std
+
+#endif // C++11
+
+#endif /* UNIQUE_FUNCTION_RECLAIMER_H_ */
@@ -0,0 +1,513 @@
+/*
+ * function_unique_table.h
+ *
+ *  A table of basic_unique_function callbacks addressed by small integer
+ *  ids, with generation-checked handles.
+ */
+
+#ifndef UNIQUE_FUNCTION_TABLE_H_
+#define UNIQUE_FUNCTION_TABLE_H_
+
+#pragma GCC system_header
+
+#include "function_unique.h"
+#include "function_unique_pool.h"
+
+#if __cplusplus >= 201103L
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace std _GLIBCXX_VISIBILITY(default)
+{
+_GLIBCXX_BEGIN_NAMESPACE_VERSION
+
+  /**
+   *  The memory behind the out-of-line targets of one
+   *  unique_function_table.
+   *
+   *  Blocks come in the size classes of unique_function_pool_allocator
+   *  and are carved from chunks that are only released with the slab, so
+   *  targets registered together sit together in memory.  Freed blocks
+   *  go on a list per class for the next target of that size.  Larger or
+   *  over-aligned requests go to operator new.  Not thread-safe.
+   */
+  class _Unique_function_slab : _Unique_function_size_classes
+  {
+  public:
+    static constexpr std::size_t _S_chunk_blocks = 16;
+
+    _Unique_function_slab() noexcept
+    : _M_free(), _M_chunks(nullptr) { }
+
+    _Unique_function_slab(const _Unique_function_slab&) = delete;
+
+    _Unique_function_slab&
+    operator=(const _Unique_function_slab&) = delete;
+
+    ~_Unique_function_slab()
+    {
+      while (_Chunk* __c = _M_chunks)
+	{
+	  _M_chunks = __c->_M_next;
+	  ::operator delete(__c);
+	}
+    }
+
+    void*
+    _M_allocate(std::size_t __bytes, std::size_t __align)
+    {
+      const std::size_t __c = _S_class(__bytes, __align);
+      if (__c == _S_classes)
+	return _S_allocate_unclassed(__bytes, __align);
+      if (!_M_free[__c])
+	_M_refill(__c);
+      _Block* __b = _M_free[__c];
+      _M_free[__c] = __b->_M_next;
+      return __b;
+    }
+
+    void
+    _M_deallocate(void* __p, std::size_t __bytes, std::size_t __align)
+    noexcept
+    {
+      const std::size_t __c = _S_class(__bytes, __align);
+      if (__c == _S_classes)
+	{
+	  _S_deallocate_unclassed(__p, __bytes, __align);
+	  return;
+	}
+      _Block* __b = ::new (__p) _Block;
+      __b->_M_next = _M_free[__c];
+      _M_free[__c] = __b;
+    }
+
+  private:
+    struct _Block
+    {
+      _Block* _M_next;
+    };
+
+    // A chunk header, followed by its blocks.
+    struct alignas(max_align_t) _Chunk
+    {
+      _Chunk* _M_next;
+    };
+
+    void
+    _M_refill(std::size_t __c)
+    {
+      const std::size_t __size = _S_min_size << __c;
+      void* __mem = ::operator new(sizeof(_Chunk) + __size * _S_chunk_blocks);
+      _Chunk* __chunk = ::new (__mem) _Chunk;
+      __chunk->_M_next = _M_chunks;
+      _M_chunks = __chunk;
+      char* __blocks = reinterpret_cast<char*>(__chunk + 1);
+      for (std::size_t __i = _S_chunk_blocks; __i-- > 0; )
+	_M_deallocate(__blocks + __i * __size, __size, 1);
+    }
+
+    _Block*	_M_free[_S_classes];
+    _Chunk*	_M_chunks;
+  };
+
+  // Allocates from the slab of a unique_function_table.
+  template<typename _Tp>
+    struct _Unique_function_slab_allocator
+    {
+      typedef _Tp value_type;
+
+      explicit
+      _Unique_function_slab_allocator(_Unique_function_slab* __slab) noexcept
+      : _M_slab(__slab) { }
+
+      template<typename _Up>
+	_Unique_function_slab_allocator(
+	    const _Unique_function_slab_allocator<_Up>& __a) noexcept
+	: _M_slab(__a._M_slab) { }
+
+      _Tp*
+      allocate(std::size_t __n)
+      {
+	static_assert(_Unique_function_size_classes::_S_allocatable<_Tp>(),
+		      "over-aligned types need aligned operator new");
+	if (__n > std::size_t(-1) / sizeof(_Tp))
+	  __throw_bad_alloc();
+	return static_cast<_Tp*>(
+	    _M_slab->_M_allocate(__n * sizeof(_Tp), __alignof__(_Tp)));
+      }
+
+      void
+      deallocate(_Tp* __p, std::size_t __n) noexcept
+      { _M_slab->_M_deallocate(__p, __n * sizeof(_Tp), __alignof__(_Tp)); }
+
+      _Unique_function_slab* _M_slab;
+    };
+
+  template<typename _Tp, typename _Up>
+    inline bool
+    operator==(const _Unique_function_slab_allocator<_Tp>& __a,
+	       const _Unique_function_slab_allocator<_Up>& __b) noexcept
+    { return __a._M_slab == __b._M_slab; }
+
+  template<typename _Tp, typename _Up>
+    inline bool
+    operator!=(const _Unique_function_slab_allocator<_Tp>& __a,
+	       const _Unique_function_slab_allocator<_Up>& __b) noexcept
+    { return __a._M_slab != __b._M_slab; }
+
+  /**
+   *  @brief A dense table of callbacks addressed by handle.
+   *
+   *  Callbacks live in arrays of slots, and a handle holds the index of
+   *  its callback's slot next to the slot's generation.  Inserting reuses
+   *  the most recently freed slot, and erasing bumps the slot's
+   *  generation, so both are O(1) and a handle to an erased callback is
+   *  recognized as stale rather than reaching whatever was registered in
+   *  its slot later.  Dispatching is an index and a compare in place of a
+   *  hash lookup.
+   *
+   *  Each wrapper is constructed in its slot, and targets that do not fit
+   *  its local buffer are allocated from a slab owned by the table, so
+   *  they are packed together rather than spread over the heap.  The
+   *  table grows by whole arrays of slots and never moves a slot, so a
+   *  pointer returned by find() stays valid until its callback is erased.
+   *
+   *  A callback may insert and erase callbacks, itself included, while
+   *  invoke() runs it.  A callback erased while any callback runs has a
+   *  stale handle at once and is destroyed when the outermost invoke()
+   *  returns.  Destroying or assigning to the table from a callback is
+   *  undefined.
+   */
+  template<typename _Signature,
+	   std::size_t _Size = sizeof(_Nocopy_types),
+	   std::size_t _Align = __alignof__(_Nocopy_types)>
+    class unique_function_table
+    {
+    public:
+      typedef basic_unique_function<_Signature, _Size, _Align> value_type;
+      typedef std::size_t					size_type;
+
+      /// Identifies one callback in the table.
+      struct handle
+      {
+	/// A handle that refers to no callback.
+	handle() noexcept
+	: index(std::uint32_t(-1)), generation(0) { }
+
+	handle(std::uint32_t __index, std::uint32_t __generation) noexcept
+	: index(__index), generation(__generation) { }
+
+	std::uint32_t index;
+	std::uint32_t generation;
+
+	friend bool
+	operator==(handle __x, handle __y) noexcept
+	{ return __x.index == __y.index && __x.generation == __y.generation; }
+
+	friend bool
+	operator!=(handle __x, handle __y) noexcept
+	{ return !(__x == __y); }
+      };
+
+      unique_function_table() noexcept
+      : _M_count(0), _M_free(_S_none), _M_size(0), _M_depth(0),
+	_M_erased(_S_none)
+      { }
+
+      /// The new table takes every callback of @a __x, which is left empty.
+      unique_function_table(unique_function_table&& __x) noexcept
+      : _M_chunks(std::move(__x._M_chunks)), _M_count(__x._M_count),
+	_M_free(__x._M_free), _M_size(__x._M_size),
+	_M_slab(std::move(__x._M_slab)), _M_depth(0), _M_erased(_S_none)
+      { __x._M_reset(); }
+
+      unique_function_table(const unique_function_table&) = delete;
+
+      unique_function_table&
+      operator=(const unique_function_table&) = delete;
+
+      // The callbacks are destroyed before the slab their targets were
+      // allocated from.
+      unique_function_table&
+      operator=(unique_function_table&& __x) noexcept
+      {
+	if (this != &__x)
+	  {
+	    _M_destroy();
+	    _M_chunks = std::move(__x._M_chunks);
+	    _M_count = __x._M_count;
+	    _M_free = __x._M_free;
+	    _M_size = __x._M_size;
+	    _M_slab = std::move(__x._M_slab);
+	    __x._M_reset();
+	  }
+	return *this;
+      }
+
+      ~unique_function_table()
+      { _M_destroy(); }
+
+      /// The number of callbacks.
+      size_type
+      size() const noexcept
+      { return _M_size; }
+
+      bool
+      empty() const noexcept
+      { return _M_size == 0; }
+
+      /**
+       *  @brief Register a callback constructed from @a __f.
+       *  @return The handle of the new callback.
+       *
+       *  The callback is stored even if @a __f is empty.
+       */
+      template<typename _Functor>
+	handle
+	insert(_Functor&& __f)
+	{
+	  const std::uint32_t __index = _M_acquire();
+	  _Slot& __slot = _M_slot(__index);
+	  typedef typename decay<_Functor>::type _Tp;
+	  _M_construct(__slot._M_addr(), std::forward<_Functor>(__f),
+		       __or_<is_same<_Tp, value_type>,
+			     __bool_constant<value_type::template
+					       stores_inline<_Tp>()>>());
+	  _M_free = __slot._M_next_free;
+	  __slot._M_next_free = _S_used;
+	  ++_M_size;
+	  return handle{ __index, __slot._M_generation };
+	}
+
+      /**
+       *  @brief Unregister the callback of @a __h.
+       *  @return @c false if @a __h was stale.
+       *
+       *  While a callback runs, the destruction is left to the outermost
+       *  invoke().
+       */
+      bool
+      erase(handle __h) noexcept
+      {
+	_Slot* __slot = _M_lookup(__h);
+	if (!__slot)
+	  return false;
+	++__slot->_M_generation;
+	--_M_size;
+	if (_M_depth)
+	  {
+	    __slot->_M_next_free = _M_erased;
+	    _M_erased = __h.index;
+	  }
+	else
+	  _M_release(*__slot, __h.index);
+	return true;
+      }
+
+      /// Whether @a __h refers to a registered callback.
+      bool
+      contains(handle __h) const noexcept
+      {
+	return __h.index < _M_count
+	  && _M_slot(__h.index)._M_generation == __h.generation;
+      }
+
+      /// The callback of @a __h, or null if @a __h is stale.
+      value_type*
+      find(handle __h) noexcept
+      {
+	_Slot* __slot = _M_lookup(__h);
+	return __slot ? __slot->_M_ptr() : nullptr;
+      }
+
+      /**
+       *  @brief Invoke the callback of @a __h with @a __args.
+       *  @return @c false, without invoking anything, if @a __h is stale.
+       *
+       *  Any result of the callback is discarded.
+       */
+      template<typename... _Args>
+	bool
+	invoke(handle __h, _Args&&... __args)
+	{
+	  _Slot* __slot = _M_lookup(__h);
+	  if (!__slot)
+	    return false;
+	  ++_M_depth;
+	  _Call_guard __guard{this};
+	  (*__slot->_M_ptr())(std::forward<_Args>(__args)...);
+	  return true;
+	}
+
+      /// Unregister every callback, making every handle stale.
+      void
+      clear() noexcept
+      {
+	for (std::uint32_t __i = 0; __i < _M_count; ++__i)
+	  if (_M_slot(__i)._M_next_free == _S_used)
+	    erase(handle{ __i, _M_slot(__i)._M_generation });
+      }
+
+    private:
+      static constexpr std::uint32_t _S_none = std::uint32_t(-1);
+      static constexpr std::uint32_t _S_used = std::uint32_t(-2);
+      static constexpr std::uint32_t _S_chunk_slots = 64;
+
+      // Holds a wrapper while the slot is used, and nothing while free.
+      struct _Slot
+      {
+	value_type*
+	_M_ptr() noexcept
+	{ return static_cast<value_type*>(_M_addr()); }
+
+	void*
+	_M_addr() noexcept
+	{ return static_cast<void*>(&_M_storage[0]); }
+
+	alignas(value_type) unsigned char _M_storage[sizeof(value_type)];
+	std::uint32_t	_M_generation;
+	// The next free or erased slot while this one is free or waiting to
+	// be destroyed, else _S_used.
+	std::uint32_t	_M_next_free;
+      };
+
+      // Ends an invoke(), and once the outermost one ends, destroys the
+      // callbacks erased while it ran.
+      struct _Call_guard
+      {
+	~_Call_guard()
+	{
+	  if (--_M_table->_M_depth == 0 && _M_table->_M_erased != _S_none)
+	    _M_table->_M_release_erased();
+	}
+
+	unique_function_table* _M_table;
+      };
+
+      _Slot&
+      _M_slot(std::uint32_t __index) const noexcept
+      {
+	return _M_chunks[__index / _S_chunk_slots][__index % _S_chunk_slots];
+      }
+
+      // The index of the first free slot, adding one if there is none.
+      // The slot stays on the free list until the caller has filled it.
+      std::uint32_t
+      _M_acquire()
+      {
+	if (_M_free == _S_none)
+	  {
+	    if (_M_count >= _S_used)
+	      __throw_length_error(__N("unique_function_table"));
+	    if (_M_count % _S_chunk_slots == 0)
+	      _M_chunks.emplace_back(
+		unique_ptr<_Slot[]>(new _Slot[_S_chunk_slots]));
+	    _Slot& __slot = _M_slot(_M_count);
+	    __slot._M_generation = 1;
+	    __slot._M_next_free = _S_none;
+	    _M_free = _M_count++;
+	  }
+	return _M_free;
+      }
+
+      template<typename _Functor>
+	void
+	_M_construct(void* __p, _Functor&& __f, true_type)
+	{ ::new (__p) value_type(std::forward<_Functor>(__f)); }
+
+      template<typename _Functor>
+	void
+	_M_construct(void* __p, _Functor&& __f, false_type)
+	{
+	  if (!_M_slab)
+	    _M_slab.reset(new _Unique_function_slab);
+	  ::new (__p) value_type(allocator_arg,
+				 _Unique_function_slab_allocator<char>(
+				   _M_slab.get()),
+				 std::forward<_Functor>(__f));
+	}
+
+      // Destroy the callback in __slot and put the slot on the free list.
+      void
+      _M_release(_Slot& __slot, std::uint32_t __index) noexcept
+      {
+	__slot._M_ptr()->~value_type();
+	__slot._M_next_free = _M_free;
+	_M_free = __index;
+      }
+
+      // Destroy the callbacks erased while invoke() ran.  A destructor
+      // may erase more, so the list is detached first.
+      void
+      _M_release_erased() noexcept
+      {
+	std::uint32_t __i = _M_erased;
+	_M_erased = _S_none;
+	while (__i != _S_none)
+	  {
+	    _Slot& __slot = _M_slot(__i);
+	    const std::uint32_t __next = __slot._M_next_free;
+	    _M_release(__slot, __i);
+	    __i = __next;
+	  }
+      }
+
+      // Destroy every callback, leaving the slots to be freed.  No invoke()
+      // is running, so no erased callback is waiting.
+      void
+      _M_destroy() noexcept
+      {
+	for (std::uint32_t __i = 0; __i < _M_count; ++__i)
+	  if (_M_slot(__i)._M_next_free == _S_used)
+	    _M_slot(__i)._M_ptr()->~value_type();
+      }
+
+      // Leave the table empty, with no slots.
+      void
+      _M_reset() noexcept
+      {
+	_M_chunks.clear();
+	_M_count = 0;
+	_M_free = _S_none;
+	_M_size = 0;
+      }
+
+      // A free slot's generation was bumped when it was freed and matches
+      // no handle, so the generation alone tells whether __h is live.
+      _Slot*
+      _M_lookup(handle __h) noexcept
+      { return contains(__h) ? &_M_slot(__h.index) : nullptr; }
+
+      vector<unique_ptr<_Slot[]>>		_M_chunks;
+      // The number of slots handed out, used or free.
+      std::uint32_t			_M_count;
+      std::uint32_t			_M_free;
+      size_type				_M_size;
+      unique_ptr<_Unique_function_slab>	_M_slab;
+      // The number of invoke() calls running.
+      std::uint32_t			_M_depth;
+      // The callbacks erased while one ran, to destroy when it returns.
+      std::uint32_t			_M_erased;
+    };
+
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
+    constexpr std::uint32_t
+    unique_function_table<_Signature, _Size, _Align>::_S_none;
+
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
+    constexpr std::uint32_t
+    unique_function_table<_Signature, _Size, _Align>::_S_used;
+
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
+    constexpr std::uint32_t
+    unique_function_table<_Signature, _Size, _Align>::_S_chunk_slots;
+
+_GLIBCXX_END_NAMESPACE_VERSION
+} // namespace std
+
+#endif // C++11
+
+#endif /* UNIQUE_FUNCTION_TABLE_H_ */
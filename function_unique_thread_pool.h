@@ -0,0 +1,363 @@
+/*
+ * function_unique_thread_pool.h
+ *
+ *  A work-stealing thread pool whose tasks are basic_unique_function
+ *  objects.
+ */
+
+#ifndef UNIQUE_FUNCTION_THREAD_POOL_H_
+#define UNIQUE_FUNCTION_THREAD_POOL_H_
+
+#pragma GCC system_header
+
+#include "function_unique.h"
+
+#if __cplusplus >= 201103L
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace std _GLIBCXX_VISIBILITY(default)
+{
+_GLIBCXX_BEGIN_NAMESPACE_VERSION
+
+  /**
+   *  @brief A fixed-size, bounded deque of tasks with one owner thread
+   *  and any number of thieves, after Chase and Lev.
+   *
+   *  The owner pushes and pops at the bottom, thieves take from the top.
+   *  The tasks live in the deque's slots, so pushing a task whose target
+   *  fits the local buffer allocates nothing.  A thief claims the top
+   *  slot by advancing the top index and only then moves the task out,
+   *  so each slot has a flag that keeps the owner from reusing it until
+   *  the thief is done.
+   */
+  template<typename _Task>
+    class _Work_stealing_deque
+    {
+    public:
+      typedef std::size_t size_type;
+
+      // The capacity is __n rounded up to a power of two.
+      explicit
+      _Work_stealing_deque(size_type __n)
+      : _M_mask(_S_round_up(__n) - 1), _M_slots(new _Slot[_M_mask + 1]),
+	_M_top(0), _M_bottom(0)
+      {
+	for (size_type __i = 0; __i <= _M_mask; ++__i)
+	  _M_slots[__i]._M_busy.store(false, memory_order_relaxed);
+      }
+
+      _Work_stealing_deque(const _Work_stealing_deque&) = delete;
+
+      _Work_stealing_deque&
+      operator=(const _Work_stealing_deque&) = delete;
+
+      ~_Work_stealing_deque()
+      {
+	for (size_type __i = 0; __i <= _M_mask; ++__i)
+	  if (_M_slots[__i]._M_busy.load(memory_order_relaxed))
+	    _M_slots[__i]._M_ptr()->~_Task();
+	delete[] _M_slots;
+      }
+
+      // Owner only.  Returns false, leaving __args untouched, when full.
+      template<typename... _Args>
+	bool
+	_M_push(_Args&&... __args)
+	{
+	  const ptrdiff_t __b = _M_bottom.load(memory_order_relaxed);
+	  const ptrdiff_t __t = _M_top.load(memory_order_acquire);
+	  _Slot& __slot = _M_slot(__b);
+	  if (size_type(__b - __t) > _M_mask
+	      || __slot._M_busy.load(memory_order_acquire))
+	    return false;
+	  ::new (__slot._M_addr()) _Task(std::forward<_Args>(__args)...);
+	  __slot._M_busy.store(true, memory_order_relaxed);
+	  _M_bottom.store(__b + 1, memory_order_release);
+	  return true;
+	}
+
+      // Owner only.  Moves the most recently pushed task into __task.
+      bool
+      _M_pop(_Task& __task) noexcept
+      {
+	const ptrdiff_t __b = _M_bottom.load(memory_order_relaxed) - 1;
+	_M_bottom.store(__b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	ptrdiff_t __t = _M_top.load(memory_order_relaxed);
+	bool __found = __t <= __b;
+	// Race any thief for the last task.
+	if (__found && __t == __b)
+	  __found = _M_top.compare_exchange_strong(__t, __t + 1,
+						   memory_order_seq_cst,
+						   memory_order_relaxed);
+	if (!__found || __t == __b)
+	  _M_bottom.store(__b + 1, memory_order_relaxed);
+	if (__found)
+	  _M_take(_M_slot(__b), __task);
+	return __found;
+      }
+
+      // Any thread.  Moves the oldest task into __task.
+      bool
+      _M_steal(_Task& __task) noexcept
+      {
+	ptrdiff_t __t = _M_top.load(memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	const ptrdiff_t __b = _M_bottom.load(memory_order_acquire);
+	if (__t >= __b
+	    || !_M_top.compare_exchange_strong(__t, __t + 1,
+					       memory_order_seq_cst,
+					       memory_order_relaxed))
+	  return false;
+	_M_take(_M_slot(__t), __task);
+	return true;
+      }
+
+    private:
+      struct _Slot
+      {
+	_Task*
+	_M_ptr() noexcept
+	{ return static_cast<_Task*>(_M_addr()); }
+
+	void*
+	_M_addr() noexcept
+	{ return static_cast<void*>(&_M_storage[0]); }
+
+	atomic<bool> _M_busy;
+	alignas(_Task) unsigned char _M_storage[sizeof(_Task)];
+      };
+
+      static size_type
+      _S_round_up(size_type __n) noexcept
+      {
+	size_type __cap = 2;
+	while (__cap < __n && __cap <= size_type(-1) / 4)
+	  __cap *= 2;
+	return __cap;
+      }
+
+      _Slot&
+      _M_slot(ptrdiff_t __pos) const noexcept
+      { return _M_slots[size_type(__pos) & _M_mask]; }
+
+      static void
+      _M_take(_Slot& __slot, _Task& __task) noexcept
+      {
+	__task = std::move(*__slot._M_ptr());
+	__slot._M_ptr()->~_Task();
+	__slot._M_busy.store(false, memory_order_release);
+      }
+
+      const size_type		_M_mask;
+      _Slot* const		_M_slots;
+      alignas(64) atomic<ptrdiff_t> _M_top;
+      alignas(64) atomic<ptrdiff_t> _M_bottom;
+    };
+
+  /**
+   *  @brief A thread pool that balances its tasks by work stealing.
+   *
+   *  Tasks are basic_unique_function<void(), @a _Size> objects, so they
+   *  may capture move-only state such as a std::promise or a
+   *  std::unique_ptr, and closures of up to @a _Size bytes are stored
+   *  without allocating.
+   *
+   *  A task submitted from one of the pool's own threads is pushed onto
+   *  that thread's deque, where it is run in LIFO order unless an idle
+   *  thread steals it.  Tasks submitted from any other thread, or from a
+   *  worker whose deque is full, go to a shared queue.  A task that exits
+   *  with an exception calls std::terminate.
+   */
+  template<std::size_t _Size = 64>
+    class unique_function_thread_pool
+    {
+    public:
+      typedef basic_unique_function<void(), _Size>	task_type;
+      typedef std::size_t				size_type;
+
+      /**
+       *  @brief Start @a __threads worker threads, each with a deque of
+       *  at least @a __deque_size tasks.
+       */
+      explicit
+      unique_function_thread_pool(
+	  size_type __threads = thread::hardware_concurrency(),
+	  size_type __deque_size = 1024)
+      : _M_pending(0), _M_sleepers(0), _M_shared_size(0), _M_stop(false)
+      {
+	if (__threads == 0)
+	  __threads = 1;
+	_M_workers.reserve(__threads);
+	for (size_type __i = 0; __i < __threads; ++__i)
+	  _M_workers.emplace_back(new _Worker(__deque_size, __i + 1));
+	for (size_type __i = 0; __i < __threads; ++__i)
+	  _M_workers[__i]->_M_thread
+	    = thread(&unique_function_thread_pool::_M_run, this, __i);
+      }
+
+      unique_function_thread_pool(const unique_function_thread_pool&) = delete;
+
+      unique_function_thread_pool&
+      operator=(const unique_function_thread_pool&) = delete;
+
+      /// Runs every task already submitted, then joins the threads.
+      ~unique_function_thread_pool()
+      {
+	{
+	  lock_guard<mutex> __lock(_M_mutex);
+	  _M_stop = true;
+	}
+	_M_wake.notify_all();
+	for (auto& __w : _M_workers)
+	  __w->_M_thread.join();
+      }
+
+      size_type
+      size() const noexcept
+      { return _M_workers.size(); }
+
+      /**
+       *  @brief Queue a task constructed from @a __args.
+       *
+       *  From a worker thread this is a push onto the worker's own deque;
+       *  from any other thread it takes the lock of the shared queue.
+       */
+      template<typename... _Args>
+	void
+	submit(_Args&&... __args)
+	{
+	  // Count the task before it becomes visible, so that no worker
+	  // can run it and decrement the count first.
+	  _M_pending.fetch_add(1, memory_order_seq_cst);
+	  __try
+	    {
+	      _Worker* __self = _S_current();
+	      if (!__self || __self->_M_pool != this
+		  || !__self->_M_deque._M_push(std::forward<_Args>(__args)...))
+		{
+		  lock_guard<mutex> __lock(_M_mutex);
+		  _M_shared.emplace_back(std::forward<_Args>(__args)...);
+		  _M_shared_size.store(_M_shared.size(), memory_order_relaxed);
+		}
+	    }
+	  __catch(...)
+	    {
+	      _M_pending.fetch_sub(1, memory_order_relaxed);
+	      __throw_exception_again;
+	    }
+	  if (_M_sleepers.load(memory_order_seq_cst))
+	    {
+	      lock_guard<mutex> __lock(_M_mutex);
+	      _M_wake.notify_one();
+	    }
+	}
+
+    private:
+      struct _Worker
+      {
+	_Worker(size_type __deque_size, size_type __seed)
+	: _M_deque(__deque_size), _M_pool(), _M_rand(__seed) { }
+
+	_Work_stealing_deque<task_type>	_M_deque;
+	unique_function_thread_pool*	_M_pool;
+	size_type			_M_rand;
+	thread				_M_thread;
+      };
+
+      static _Worker*&
+      _S_current() noexcept
+      {
+	static thread_local _Worker* __current = nullptr;
+	return __current;
+      }
+
+      // Find a task: own deque first, then the shared queue, then steal
+      // from the other workers starting at a random one.
+      bool
+      _M_find(_Worker& __self, task_type& __task)
+      {
+	if (__self._M_deque._M_pop(__task))
+	  return true;
+	if (_M_shared_size.load(memory_order_relaxed))
+	  {
+	    lock_guard<mutex> __lock(_M_mutex);
+	    if (!_M_shared.empty())
+	      {
+		__task = std::move(_M_shared.front());
+		_M_shared.pop_front();
+		_M_shared_size.store(_M_shared.size(), memory_order_relaxed);
+		return true;
+	      }
+	  }
+	const size_type __n = _M_workers.size();
+	__self._M_rand ^= __self._M_rand << 13;
+	__self._M_rand ^= __self._M_rand >> 7;
+	__self._M_rand ^= __self._M_rand << 17;
+	for (size_type __i = 0, __v = __self._M_rand % __n; __i < __n;
+	     ++__i, __v = (__v + 1 == __n ? 0 : __v + 1))
+	  if (_M_workers[__v].get() != &__self
+	      && _M_workers[__v]->_M_deque._M_steal(__task))
+	    return true;
+	return false;
+      }
+
+      void
+      _M_run(size_type __index)
+      {
+	_Worker& __self = *_M_workers[__index];
+	__self._M_pool = this;
+	_S_current() = &__self;
+	task_type __task;
+	for (;;)
+	  {
+	    // Spin briefly before sleeping, since in fork/join work a new
+	    // task usually appears within microseconds.
+	    bool __found = false;
+	    for (int __spin = 0; !__found && __spin < 64; ++__spin)
+	      if (!(__found = _M_find(__self, __task)))
+		this_thread::yield();
+	    if (__found)
+	      {
+		_M_pending.fetch_sub(1, memory_order_relaxed);
+		__task();
+		__task = nullptr;
+		continue;
+	      }
+
+	    unique_lock<mutex> __lock(_M_mutex);
+	    _M_sleepers.fetch_add(1, memory_order_seq_cst);
+	    _M_wake.wait(__lock, [this] {
+	      return _M_pending.load(memory_order_seq_cst) != 0 || _M_stop;
+	    });
+	    _M_sleepers.fetch_sub(1, memory_order_relaxed);
+	    if (_M_stop && _M_pending.load(memory_order_relaxed) == 0)
+	      break;
+	  }
+	_S_current() = nullptr;
+      }
+
+      vector<unique_ptr<_Worker>>	_M_workers;
+      atomic<size_type>			_M_pending;
+      atomic<size_type>			_M_sleepers;
+      mutex				_M_mutex;
+      condition_variable		_M_wake;
+      deque<task_type>			_M_shared;
+      // The size of _M_shared, readable without taking the lock.
+      atomic<size_type>			_M_shared_size;
+      bool				_M_stop;
+    };
+
+_GLIBCXX_END_NAMESPACE_VERSION
+} // namespace std
+
+#endif // C++11
+
+#endif /* UNIQUE_FUNCTION_THREAD_POOL_H_ */
@@ -0,0 +1,288 @@
+/*
+ * function_unique_vector.h
+ *
+ *  A contiguous container of basic_unique_function that grows by
+ *  relocating its elements bytewise.
+ */
+
+#ifndef UNIQUE_FUNCTION_VECTOR_H_
+#define UNIQUE_FUNCTION_VECTOR_H_
+
+#pragma GCC system_header
+
+#include "function_unique.h"
+
+#if __cplusplus >= 201103L
+
+#include <bits/allocator.h>
+#include <bits/functexcept.h>
+#include <bits/stl_algobase.h>
+
+namespace std _GLIBCXX_VISIBILITY(default)
+{
+_GLIBCXX_BEGIN_NAMESPACE_VERSION
+
+  /**
+   *  @brief A vector of polymorphic function object wrappers.
+   *
+   *  Behaves like a move-only std::vector of basic_unique_function, but
+   *  when its storage grows the elements are moved with
+   *  uninitialized_relocate_n: one memcpy of the whole array, followed by
+   *  a real move only for the targets that are not trivially relocatable.
+   */
+  template<typename _Signature,
+	   std::size_t _Size = sizeof(_Nocopy_types),
+	   std::size_t _Align = __alignof__(_Nocopy_types)>
+    class unique_function_vector
+    {
+    public:
+      typedef basic_unique_function<_Signature, _Size, _Align> value_type;
+      typedef value_type*					pointer;
+      typedef const value_type*					const_pointer;
+      typedef value_type&					reference;
+      typedef const value_type&					const_reference;
+      typedef value_type*					iterator;
+      typedef const value_type*					const_iterator;
+      typedef std::size_t					size_type;
+
+      unique_function_vector() noexcept
+      : _M_start(), _M_finish(), _M_end_of_storage() { }
+
+      unique_function_vector(unique_function_vector&& __x) noexcept
+      : _M_start(__x._M_start), _M_finish(__x._M_finish),
+	_M_end_of_storage(__x._M_end_of_storage)
+      { __x._M_start = __x._M_finish = __x._M_end_of_storage = pointer(); }
+
+      unique_function_vector(const unique_function_vector&) = delete;
+
+      unique_function_vector&
+      operator=(const unique_function_vector&) = delete;
+
+      unique_function_vector&
+      operator=(unique_function_vector&& __x) noexcept
+      {
+	unique_function_vector(std::move(__x)).swap(*this);
+	return *this;
+      }
+
+      ~unique_function_vector()
+      {
+	clear();
+	_M_deallocate(_M_start, capacity());
+      }
+
+      // iterators
+      iterator
+      begin() noexcept
+      { return _M_start; }
+
+      const_iterator
+      begin() const noexcept
+      { return _M_start; }
+
+      iterator
+      end() noexcept
+      { return _M_finish; }
+
+      const_iterator
+      end() const noexcept
+      { return _M_finish; }
+
+      // capacity
+      size_type
+      size() const noexcept
+      { return size_type(_M_finish - _M_start); }
+
+      size_type
+      capacity() const noexcept
+      { return size_type(_M_end_of_storage - _M_start); }
+
+      bool
+      empty() const noexcept
+      { return _M_start == _M_finish; }
+
+      /**
+       *  @brief Attempt to preallocate enough memory for @a __n elements.
+       *
+       *  Existing elements are relocated, not moved one by one.
+       */
+      void
+      reserve(size_type __n)
+      {
+	if (__n > capacity())
+	  _M_reallocate(__n);
+      }
+
+      /**
+       *  @brief Resize to @a __n elements, appending empty wrappers or
+       *  destroying trailing ones as needed.
+       */
+      void
+      resize(size_type __n)
+      {
+	if (__n < size())
+	  _M_erase_at_end(_M_start + __n);
+	else
+	  {
+	    reserve(__n);
+	    for (; _M_finish != _M_start + __n; ++_M_finish)
+	      ::new (static_cast<void*>(_M_finish)) value_type();
+	  }
+      }
+
+      // element access
+      reference
+      operator[](size_type __n) noexcept
+      {
+	__glibcxx_assert(__n < size());
+	return _M_start[__n];
+      }
+
+      const_reference
+      operator[](size_type __n) const noexcept
+      {
+	__glibcxx_assert(__n < size());
+	return _M_start[__n];
+      }
+
+      pointer
+      data() noexcept
+      { return _M_start; }
+
+      const_pointer
+      data() const noexcept
+      { return _M_start; }
+
+      // modifiers
+      /**
+       *  @brief Construct a wrapper from @a __args at the end.
+       *  @return A reference to the new element.
+       *
+       *  If the storage has to grow, the new element is constructed
+       *  before the existing ones are relocated, so @a __args may refer
+       *  to an element of this vector.
+       */
+      template<typename... _Args>
+	reference
+	emplace_back(_Args&&... __args)
+	{
+	  if (_M_finish != _M_end_of_storage)
+	    {
+	      ::new (static_cast<void*>(_M_finish))
+		value_type(std::forward<_Args>(__args)...);
+	      return *_M_finish++;
+	    }
+	  return _M_realloc_append(std::forward<_Args>(__args)...);
+	}
+
+      void
+      push_back(value_type&& __x)
+      { emplace_back(std::move(__x)); }
+
+      void
+      pop_back() noexcept
+      {
+	__glibcxx_assert(!empty());
+	--_M_finish;
+	_M_finish->~value_type();
+      }
+
+      void
+      clear() noexcept
+      { _M_erase_at_end(_M_start); }
+
+      void
+      swap(unique_function_vector& __x) noexcept
+      {
+	std::swap(_M_start, __x._M_start);
+	std::swap(_M_finish, __x._M_finish);
+	std::swap(_M_end_of_storage, __x._M_end_of_storage);
+      }
+
+    private:
+      typedef std::allocator<value_type> _Alloc;
+
+      static pointer
+      _M_allocate(size_type __n)
+      { return __n ? _Alloc().allocate(__n) : pointer(); }
+
+      static void
+      _M_deallocate(pointer __p, size_type __n)
+      {
+	if (__p)
+	  _Alloc().deallocate(__p, __n);
+      }
+
+      size_type
+      _M_next_capacity() const
+      {
+	const size_type __max = size_type(-1) / sizeof(value_type);
+	if (size() == __max)
+	  __throw_length_error(__N("unique_function_vector::_M_realloc"));
+	const size_type __len = size() + std::max(size(), size_type(1));
+	return (__len < size() || __len > __max) ? __max : __len;
+      }
+
+      void
+      _M_reallocate(size_type __n)
+      {
+	pointer __new_start = _M_allocate(__n);
+	pointer __new_finish
+	  = std::uninitialized_relocate_n(_M_start, size(), __new_start);
+	_M_deallocate(_M_start, capacity());
+	_M_start = __new_start;
+	_M_finish = __new_finish;
+	_M_end_of_storage = __new_start + __n;
+      }
+
+      template<typename... _Args>
+	reference
+	_M_realloc_append(_Args&&... __args)
+	{
+	  const size_type __len = _M_next_capacity();
+	  const size_type __n = size();
+	  pointer __new_start = _M_allocate(__len);
+	  __try
+	    {
+	      ::new (static_cast<void*>(__new_start + __n))
+		value_type(std::forward<_Args>(__args)...);
+	    }
+	  __catch(...)
+	    {
+	      _M_deallocate(__new_start, __len);
+	      __throw_exception_again;
+	    }
+	  std::uninitialized_relocate_n(_M_start, __n, __new_start);
+	  _M_deallocate(_M_start, capacity());
+	  _M_start = __new_start;
+	  _M_finish = __new_start + __n + 1;
+	  _M_end_of_storage = __new_start + __len;
+	  return _M_finish[-1];
+	}
+
+      void
+      _M_erase_at_end(pointer __pos) noexcept
+      {
+	for (pointer __p = __pos; __p != _M_finish; ++__p)
+	  __p->~value_type();
+	_M_finish = __pos;
+      }
+
+      pointer _M_start;
+      pointer _M_finish;
+      pointer _M_end_of_storage;
+    };
+
+  /// Swap the contents of two unique_function_vector objects.
+  template<typename _Signature, std::size_t _Size, std::size_t _Align>
+    inline void
+    swap(unique_function_vector<_Signature, _Size, _Align>& __x,
+	 unique_function_vector<_Signature, _Size, _Align>& __y) noexcept
+    { __x.swap(__y); }
+
+_GLIBCXX_END_NAMESPACE_VERSION
+} // namespace std
+
+#endif // C++11
+
+#endif /* UNIQUE_FUNCTION_VECTOR_H_ */
@@ -0,0 +1,75 @@
+// Constant initialization of unique_function (C++20): empty wrappers,
+// pointers to functions and captureless lambdas.
+
+#include <functional>
+
+#include "function_unique.h"
+#include "testsuite_hooks.h"
+
+int add_one(int i) { return i + 1; }
+
+constinit std::unique_function<int(int)> empty;
+constinit std::unique_function<int(int)> null_target = nullptr;
+constinit std::unique_function<int(int)> function_pointer = add_one;
+constinit std::unique_function<int(int)> lambda = [](int i) { return i * 3; };
+constinit std::unique_function<int(int) const noexcept> const_lambda
+  = [](int i) noexcept { return i - 1; };
+
+// The wrappers are usable at run time as if initialized dynamically.
+void
+test01()
+{
+  VERIFY( !empty );
+  VERIFY( !null_target );
+  VERIFY( function_pointer(1) == 2 );
+  VERIFY( lambda(2) == 6 );
+  VERIFY( const_lambda(3) == 2 );
+
+  bool caught = false;
+  try
+    {
+      empty(1);
+    }
+  catch (const std::bad_function_call&)
+    {
+      caught = true;
+    }
+  VERIFY( caught );
+}
+
+// They can be moved from, assigned to and destroyed like any other.
+void
+test02()
+{
+  std::unique_function<int(int)> f = std::move(lambda);
+  VERIFY( !lambda );
+  VERIFY( f(1) == 3 );
+
+  empty = std::move(function_pointer);
+  VERIFY( empty(1) == 2 );
+  VERIFY( !function_pointer );
+
+  function_pointer = [](int i) { return -i; };
+  VERIFY( function_pointer(4) == -4 );
+}
+
+// A wrapper can also be created and destroyed in a constant expression.
+void
+test03()
+{
+  constexpr bool ok = [] {
+    std::unique_function<int(int)> f = [](int i) { return i; };
+    std::unique_function<int(int)> g = add_one;
+    std::unique_function<int(int)> h;
+    return true;
+  }();
+  static_assert( ok );
+}
+
+int
+main()
+{
+  test01();
+  test02();
+  test03();
+}
@@ -0,0 +1,352 @@
+// basic_unique_function: local storage, allocators, empty wrappers, moves,
+// swaps, relocation, the lack of copying, and in-place construction.
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+#include "function_unique.h"
+#include "function_unique_vector.h"
+#include "testsuite_hooks.h"
+
+using function = std::unique_function<int(int)>;
+
+// The live objects and moves of the counted target types below.
+struct counters
+{
+  int live = 0;
+  int moves = 0;
+} counts;
+
+// A local target that must not be moved by copying its bytes: it checks
+// on every call that its self pointer still refers to it.
+struct self_pointing
+{
+  self_pointing* self = this;
+  int value;
+
+  explicit self_pointing(int value) : value(value) { ++counts.live; }
+
+  self_pointing(self_pointing&& x) noexcept : value(x.value)
+  { ++counts.live; ++counts.moves; }
+
+  ~self_pointing() { --counts.live; }
+
+  int operator()(int i) const
+  {
+    VERIFY( self == this );
+    return i + value;
+  }
+};
+
+// A target too large for the local buffer.
+struct large
+{
+  char pad[4 * sizeof(function)] = { };
+
+  large() { ++counts.live; }
+
+  large(large&&) { ++counts.live; ++counts.moves; }
+
+  ~large() { --counts.live; }
+
+  int operator()(int i) const { return i * 2; }
+};
+
+// A small target whose move constructor may throw.
+struct throwing_move
+{
+  throwing_move() = default;
+  throwing_move(throwing_move&&) { }
+
+  int operator()(int i) const { return i - 1; }
+};
+
+// An allocator that counts what is allocated through it.
+template<typename T>
+  struct counting_allocator
+  {
+    using value_type = T;
+
+    int* allocations;
+    int* deallocations;
+
+    counting_allocator(int* a, int* d) : allocations(a), deallocations(d) { }
+
+    template<typename U>
+      counting_allocator(const counting_allocator<U>& a)
+      : allocations(a.allocations), deallocations(a.deallocations) { }
+
+    T*
+    allocate(std::size_t n)
+    {
+      ++*allocations;
+      return std::allocator<T>().allocate(n);
+    }
+
+    void
+    deallocate(T* p, std::size_t n)
+    {
+      ++*deallocations;
+      std::allocator<T>().deallocate(p, n);
+    }
+
+    template<typename U>
+      bool operator==(const counting_allocator<U>&) const { return true; }
+    template<typename U>
+      bool operator!=(const counting_allocator<U>&) const { return false; }
+  };
+
+int add_one(int i) { return i + 1; }
+
+// Nothrow movable targets are stored locally even when they are not
+// trivially copyable; the rest go on the heap.
+void
+test01()
+{
+  auto owner = [p = std::make_unique<int>(1)](int i) { return i + *p; };
+  static_assert( function::stores_inline<decltype(owner)>() );
+  static_assert( function::stores_inline<self_pointing>() );
+  static_assert( function::stores_inline<int(*)(int)>() );
+  static_assert( !function::stores_inline<throwing_move>() );
+  static_assert( !function::stores_inline<large>() );
+
+  function f = std::move(owner);
+  VERIFY( f(1) == 2 );
+  function g = throwing_move();
+  VERIFY( g(1) == 0 );
+
+  counts = counters();
+  {
+    function h = large();
+    VERIFY( h(2) == 4 );
+    VERIFY( counts.live == 1 );
+  }
+  VERIFY( counts.live == 0 );
+}
+
+// A target that does not fit locally is allocated with the allocator,
+// which is not used for a target that fits.
+void
+test02()
+{
+  int allocs = 0, deallocs = 0;
+  counting_allocator<char> alloc(&allocs, &deallocs);
+  counts = counters();
+  {
+    function f(std::allocator_arg, alloc, add_one);
+    VERIFY( f(1) == 2 );
+    VERIFY( allocs == 0 );
+
+    function g(std::allocator_arg, alloc, large());
+    VERIFY( g(3) == 6 );
+    VERIFY( allocs == 1 );
+    VERIFY( counts.live == 1 );
+
+    // Moving the wrapper moves the pointer to the block, not the target.
+    int moves = counts.moves;
+    function h = std::move(g);
+    VERIFY( counts.moves == moves );
+    VERIFY( h(3) == 6 );
+
+    f.assign(large(), alloc);
+    VERIFY( allocs == 2 );
+    VERIFY( f(4) == 8 );
+    VERIFY( deallocs == 0 );
+  }
+  VERIFY( deallocs == 2 );
+  VERIFY( counts.live == 0 );
+}
+
+// An empty wrapper throws bad_function_call, and so does a moved-from one.
+void
+test03()
+{
+  function f;
+  VERIFY( !f );
+  VERIFY( f == nullptr );
+
+  bool caught = false;
+  try
+    {
+      f(1);
+    }
+  catch (const std::bad_function_call&)
+    {
+      caught = true;
+    }
+  VERIFY( caught );
+
+  int (*null)(int) = nullptr;
+  function g = null;
+  VERIFY( !g );
+
+  function h = add_one;
+  function i = std::move(h);
+  VERIFY( !h );
+  VERIFY( i(1) == 2 );
+  caught = false;
+  try
+    {
+      h(1);
+    }
+  catch (const std::bad_function_call&)
+    {
+      caught = true;
+    }
+  VERIFY( caught );
+}
+
+// Moves cannot throw, and move assignment destroys the old target.
+void
+test04()
+{
+  static_assert( std::is_nothrow_move_constructible<function>::value );
+  static_assert( std::is_nothrow_move_assignable<function>::value );
+
+  counts = counters();
+  function f = self_pointing(1);
+  function g = self_pointing(2);
+  VERIFY( counts.live == 2 );
+
+  f = std::move(g);
+  VERIFY( counts.live == 1 );
+  VERIFY( !g );
+  VERIFY( f(0) == 2 );
+
+  f = nullptr;
+  VERIFY( counts.live == 0 );
+  VERIFY( !f );
+}
+
+// Swapping exchanges targets, and moves local targets through their own
+// move constructors; swapping with itself does nothing.
+void
+test05()
+{
+  counts = counters();
+  function f = self_pointing(1);
+  function g = self_pointing(2);
+
+  f.swap(g);
+  VERIFY( f(0) == 2 );
+  VERIFY( g(0) == 1 );
+  VERIFY( counts.live == 2 );
+
+  swap(f, g);
+  VERIFY( f(0) == 1 );
+
+  f.swap(f);
+  VERIFY( f(0) == 1 );
+  VERIFY( counts.live == 2 );
+
+  function e;
+  e.swap(f);
+  VERIFY( !f );
+  VERIFY( e(0) == 1 );
+  VERIFY( counts.live == 2 );
+}
+
+// Relocation copies bytes only for targets that allow it.
+void
+test06()
+{
+  counts = counters();
+  function f = add_one;
+  function g = self_pointing(3);
+  function h = large();
+  VERIFY( f.trivially_relocatable() );
+  VERIFY( !g.trivially_relocatable() );
+  VERIFY( h.trivially_relocatable() );
+
+  alignas(function) unsigned char buf[sizeof(function)];
+  function* p = reinterpret_cast<function*>(buf);
+  std::relocate(p, &g);
+  VERIFY( (*p)(1) == 4 );
+  VERIFY( counts.live == 2 );
+  p->~function();
+  VERIFY( counts.live == 1 );
+
+  std::unique_function_vector<int(int)> v;
+  for (int i = 0; i < 100; ++i)
+    if (i % 2)
+      v.push_back(function(self_pointing(i)));
+    else
+      v.emplace_back(add_one);
+  VERIFY( v.size() == 100 );
+  for (int i = 0; i < 100; ++i)
+    VERIFY( v[i](1) == (i % 2 ? 1 + i : 2) );
+  v.clear();
+  VERIFY( counts.live == 1 );
+}
+
+// A wrapper cannot be copied, so its target need not be copyable.
+void
+test07()
+{
+  static_assert( !std::is_copy_constructible<function>::value );
+  static_assert( !std::is_copy_assignable<function>::value );
+
+  auto owner = [p = std::make_unique<int>(5)](int i) { return i * *p; };
+  static_assert( !std::is_copy_constructible<decltype(owner)>::value );
+  function f = std::move(owner);
+  VERIFY( f(2) == 10 );
+}
+
+// In-place construction builds the target where it is stored, without
+// moving a temporary.
+void
+test08()
+{
+  counts = counters();
+  function f(std::in_place_type<self_pointing>, 4);
+  VERIFY( counts.moves == 0 );
+  VERIFY( f(1) == 5 );
+
+  function g(std::in_place_type<large>);
+  VERIFY( counts.moves == 0 );
+  VERIFY( g(1) == 2 );
+
+  self_pointing& t = f.emplace<self_pointing>(6);
+  VERIFY( counts.moves == 0 );
+  VERIFY( t.value == 6 );
+  VERIFY( f(1) == 7 );
+  VERIFY( counts.live == 2 );
+
+  // Unlike the converting constructor, a null pointer is still a target.
+  function h(std::in_place_type<int(*)(int)>, nullptr);
+  VERIFY( static_cast<bool>(h) );
+}
+
+// The target can be inspected by type.
+void
+test09()
+{
+  function f = add_one;
+  VERIFY( f.target_type() == typeid(int(*)(int)) );
+  VERIFY( f.target<int(*)(int)>() != nullptr );
+  VERIFY( *f.target<int(*)(int)>() == &add_one );
+  VERIFY( f.target<throwing_move>() == nullptr );
+
+  function e;
+  VERIFY( e.target_type() == typeid(void) );
+}
+
+int
+main()
+{
+  test01();
+  test02();
+  test03();
+  test04();
+  test05();
+  test06();
+  test07();
+  test08();
+  test09();
+}
@@ -0,0 +1,129 @@
+// unique_function_ref: what it can refer to, how the referred-to callable
+// is invoked, and references to the target of a wrapper.
+
+#include <array>
+#include <functional>
+#include <type_traits>
+
+#include "function_unique.h"
+#include "testsuite_hooks.h"
+
+using ref = std::unique_function_ref<int(int)>;
+
+int twice(int i) { return i * 2; }
+
+struct counter
+{
+  int calls = 0;
+  int operator()(int i) { ++calls; return i; }
+};
+
+struct const_only
+{
+  int operator()(int i) const { return i + 10; }
+};
+
+// A reference does not own its callable, and can be copied freely.
+void
+test01()
+{
+  static_assert( std::is_trivially_copyable<ref>::value );
+  static_assert( std::is_nothrow_constructible<ref, counter&>::value );
+
+  ref r = twice;
+  VERIFY( r(3) == 6 );
+  ref s = &twice;
+  VERIFY( s(4) == 8 );
+
+  // The callable is referred to, not copied.
+  counter c;
+  ref t = c;
+  ref u = t;
+  VERIFY( t(1) == 1 );
+  VERIFY( u(2) == 2 );
+  VERIFY( c.calls == 2 );
+
+  int base = 5;
+  auto add = [&base](int i) { return i + base; };
+  ref v = add;
+  base = 6;
+  VERIFY( v(1) == 7 );
+}
+
+// A const signature only binds callables that are callable as const, and
+// a noexcept one only those that cannot throw.
+void
+test02()
+{
+  using cref = std::unique_function_ref<int(int) const>;
+  static_assert( std::is_constructible<cref, const_only&>::value );
+  static_assert( std::is_constructible<cref, const const_only&>::value );
+  static_assert( !std::is_constructible<cref, counter&>::value );
+  static_assert( !std::is_constructible<ref, const counter&>::value );
+
+  const const_only k{};
+  cref r = k;
+  VERIFY( r(1) == 11 );
+
+  using nref = std::unique_function_ref<int(int) noexcept>;
+  auto nothrow = [](int i) noexcept { return i; };
+  static_assert( std::is_constructible<nref, decltype(nothrow)&>::value );
+  static_assert( !std::is_constructible<nref, counter&>::value );
+  static_assert( std::is_nothrow_invocable<nref, int>::value );
+  nref n = nothrow;
+  VERIFY( n(9) == 9 );
+}
+
+// A reference to a wrapper of the same signature refers to its target, so
+// it is called without going through the wrapper.
+void
+test03()
+{
+  std::unique_function<int(int)> f = counter();
+  ref r = f;
+  VERIFY( r(1) == 1 );
+  VERIFY( r(2) == 2 );
+  VERIFY( f.target<counter>()->calls == 2 );
+
+  // A wrapper on the heap is referred to in the same way.
+  std::unique_function<int(int)> g
+    = [pad = std::array<char, 64>(), c = counter()](int i) mutable
+      { return c(i) + pad[0]; };
+  ref s = g;
+  VERIFY( s(7) == 7 );
+
+  // A reference to an empty wrapper throws when called.
+  std::unique_function<int(int)> e;
+  ref t = e;
+  bool caught = false;
+  try
+    {
+      t(1);
+    }
+  catch (const std::bad_function_call&)
+    {
+      caught = true;
+    }
+  VERIFY( caught );
+}
+
+// A wrapper of another signature is referred to like any callable, so it
+// follows whatever target it has when called.
+void
+test04()
+{
+  std::unique_function<long(long)> f = [](long i) { return i + 1; };
+  ref r = f;
+  VERIFY( r(1) == 2 );
+  f = [](long i) { return i + 2; };
+  VERIFY( r(1) == 3 );
+}
+
+int
+main()
+{
+  test01();
+  test02();
+  test03();
+  test04();
+}
@@ -0,0 +1,269 @@
+// Qualified signatures: which wrappers can be called through which value
+// categories, which targets each signature accepts, and how the target is
+// invoked.
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "function_unique.h"
+#include "testsuite_hooks.h"
+
+template<typename Sig>
+  using uf = std::unique_function<Sig>;
+
+// Whether a wrapper can be called through an expression of type Q,
+// e.g. const F& or F&&.
+template<typename Q>
+  constexpr bool callable = std::is_invocable_v<Q>;
+
+// A target callable only as a non-const lvalue.
+struct lvalue_only
+{
+  int operator()() & { return 1; }
+};
+
+// A target callable only as a non-const rvalue.
+struct rvalue_only
+{
+  int operator()() && { return 2; }
+};
+
+// A target callable as a const lvalue or rvalue.
+struct const_callable
+{
+  int operator()() const { return 3; }
+};
+
+// A target callable only as a const rvalue.
+struct const_rvalue_only
+{
+  int operator()() const&& { return 4; }
+};
+
+// A target callable only when non-const, whatever its value category.
+struct mutable_only
+{
+  int operator()() { return 5; }
+};
+
+struct may_throw
+{
+  void operator()() const { }
+};
+
+struct no_throw
+{
+  void operator()() const noexcept { }
+};
+
+// An unqualified signature is called like a non-const member without a
+// ref-qualifier, and needs a target callable as a non-const lvalue.
+void
+test01()
+{
+  using F = uf<int()>;
+  static_assert( callable<F&> );
+  static_assert( callable<F&&> );
+  static_assert( !callable<const F&> );
+  static_assert( !callable<const F&&> );
+
+  static_assert( std::is_constructible_v<F, lvalue_only> );
+  static_assert( std::is_constructible_v<F, const_callable> );
+  static_assert( std::is_constructible_v<F, mutable_only> );
+  static_assert( !std::is_constructible_v<F, rvalue_only> );
+  static_assert( !std::is_constructible_v<F, const_rvalue_only> );
+
+  F f = lvalue_only();
+  VERIFY( f() == 1 );
+  VERIFY( std::move(f)() == 1 );
+
+  // The target is not const, so its state can change between calls.
+  int n = 0;
+  uf<int()> counter = [n]() mutable { return ++n; };
+  VERIFY( counter() == 1 );
+  VERIFY( counter() == 2 );
+  VERIFY( n == 0 );
+}
+
+// A const signature can be called through any value category, and
+// accepts only targets callable as const lvalues.
+void
+test02()
+{
+  using F = uf<int() const>;
+  static_assert( callable<F&> );
+  static_assert( callable<F&&> );
+  static_assert( callable<const F&> );
+  static_assert( callable<const F&&> );
+
+  static_assert( std::is_constructible_v<F, const_callable> );
+  static_assert( !std::is_constructible_v<F, mutable_only> );
+  static_assert( !std::is_constructible_v<F, lvalue_only> );
+  static_assert( !std::is_constructible_v<F, rvalue_only> );
+  static_assert( !std::is_constructible_v<F, const_rvalue_only> );
+
+  // A mutable lambda has a non-const call operator.
+  int n = 0;
+  auto inc = [n]() mutable { return ++n; };
+  static_assert( !std::is_constructible_v<F, decltype(inc)> );
+
+  const F f = const_callable();
+  VERIFY( f() == 3 );
+  VERIFY( std::move(f)() == 3 );
+}
+
+// An lvalue-qualified signature can only be called through a non-const
+// lvalue, and a const lvalue-qualified one through any const reference.
+void
+test03()
+{
+  using F = uf<int() &>;
+  static_assert( callable<F&> );
+  static_assert( !callable<F&&> );
+  static_assert( !callable<const F&> );
+  static_assert( !callable<const F&&> );
+  static_assert( std::is_constructible_v<F, lvalue_only> );
+  static_assert( std::is_constructible_v<F, mutable_only> );
+  static_assert( !std::is_constructible_v<F, rvalue_only> );
+
+  F f = lvalue_only();
+  VERIFY( f() == 1 );
+
+  using G = uf<int() const &>;
+  static_assert( callable<G&> );
+  static_assert( callable<G&&> );
+  static_assert( callable<const G&> );
+  static_assert( callable<const G&&> );
+  static_assert( std::is_constructible_v<G, const_callable> );
+  static_assert( !std::is_constructible_v<G, mutable_only> );
+  static_assert( !std::is_constructible_v<G, const_rvalue_only> );
+
+  const G g = const_callable();
+  VERIFY( g() == 3 );
+}
+
+// An rvalue-qualified signature can only be called through an rvalue, and
+// invokes its target as an rvalue too.
+void
+test04()
+{
+  using F = uf<int() &&>;
+  static_assert( !callable<F&> );
+  static_assert( callable<F&&> );
+  static_assert( !callable<const F&> );
+  static_assert( !callable<const F&&> );
+  static_assert( std::is_constructible_v<F, rvalue_only> );
+  static_assert( std::is_constructible_v<F, mutable_only> );
+  static_assert( !std::is_constructible_v<F, lvalue_only> );
+
+  F f = rvalue_only();
+  VERIFY( std::move(f)() == 2 );
+
+  // A one-shot target may give away its state when called.
+  uf<std::unique_ptr<int>() &&> once
+    = [p = std::make_unique<int>(7)]() mutable { return std::move(p); };
+  std::unique_ptr<int> p = std::move(once)();
+  VERIFY( p && *p == 7 );
+
+  using G = uf<int() const &&>;
+  static_assert( !callable<G&> );
+  static_assert( callable<G&&> );
+  static_assert( !callable<const G&> );
+  static_assert( callable<const G&&> );
+  static_assert( std::is_constructible_v<G, const_rvalue_only> );
+  static_assert( std::is_constructible_v<G, const_callable> );
+  static_assert( !std::is_constructible_v<G, rvalue_only> );
+  static_assert( !std::is_constructible_v<G, mutable_only> );
+
+  const G g = const_rvalue_only();
+  VERIFY( std::move(g)() == 4 );
+}
+
+// A noexcept signature rejects targets that may throw, and its call
+// operator is noexcept whatever the other qualifiers.
+void
+test05()
+{
+  using F = uf<void() noexcept>;
+  static_assert( std::is_constructible_v<F, no_throw> );
+  static_assert( !std::is_constructible_v<F, may_throw> );
+  static_assert( std::is_nothrow_invocable_v<F&> );
+  static_assert( !std::is_nothrow_invocable_v<uf<void()>&> );
+
+  static_assert( std::is_constructible_v<uf<void() const noexcept>,
+					 no_throw> );
+  static_assert( !std::is_constructible_v<uf<void() const noexcept>,
+					  may_throw> );
+  static_assert( std::is_nothrow_invocable_v<
+		   const uf<void() const & noexcept>&> );
+  static_assert( std::is_nothrow_invocable_v<uf<void() && noexcept>&&> );
+
+  // A function must itself be noexcept to be the target.
+  void (*nothrow_fn)() noexcept = [] () noexcept { };
+  void (*fn)() = [] { };
+  static_assert( std::is_constructible_v<F, decltype(nothrow_fn)> );
+  static_assert( !std::is_constructible_v<F, decltype(fn)> );
+
+  bool called = false;
+  F f = [&called] () noexcept { called = true; };
+  f();
+  VERIFY( called );
+
+  // Without noexcept, a noexcept target is still accepted.
+  uf<void()> g = no_throw();
+  g();
+}
+
+// The argument types are those of the signature, whatever its qualifiers,
+// and arguments are forwarded to the target without copies.
+void
+test06()
+{
+  uf<int(std::unique_ptr<int>) const &&> f
+    = [](std::unique_ptr<int> p) { return *p; };
+  VERIFY( std::move(f)(std::make_unique<int>(5)) == 5 );
+
+  uf<void(int&) &> g = [](int& i) { ++i; };
+  int i = 0;
+  g(i);
+  g(i);
+  VERIFY( i == 2 );
+
+  // The wrapper can be moved between calls of an lvalue signature.
+  uf<void(int&) &> h = std::move(g);
+  VERIFY( !g );
+  h(i);
+  VERIFY( i == 3 );
+}
+
+// invoke_unchecked has the same qualifiers as the call operator.
+void
+test07()
+{
+  using F = uf<int() &&>;
+  static_assert( std::is_invocable_v<decltype(&F::invoke_unchecked), F&&> );
+  static_assert( !std::is_invocable_v<decltype(&F::invoke_unchecked), F&> );
+
+  using G = uf<int() const>;
+  static_assert( std::is_invocable_v<decltype(&G::invoke_unchecked),
+				     const G&> );
+
+  F f = rvalue_only();
+  VERIFY( std::move(f).invoke_unchecked() == 2 );
+  const G g = const_callable();
+  VERIFY( g.invoke_unchecked() == 3 );
+}
+
+int
+main()
+{
+  test01();
+  test02();
+  test03();
+  test04();
+  test05();
+  test06();
+  test07();
+}
@@ -0,0 +1,248 @@
+// unique_function_queue: ordering, the full and empty cases, a target
+// whose move constructor throws, and many producers against one consumer.
+
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "function_unique.h"
+#include "function_unique_queue.h"
+#include "testsuite_hooks.h"
+
+using queue = std::unique_function_queue<void()>;
+
+// A target whose move constructor throws while throw_on_move is set.
+struct throwing_move
+{
+  static bool throw_on_move;
+
+  throwing_move() = default;
+
+  throwing_move(throwing_move&&)
+  {
+    if (throw_on_move)
+      throw std::runtime_error("move");
+  }
+
+  void operator()() const { }
+};
+
+bool throwing_move::throw_on_move = false;
+
+// The capacity is rounded up to a power of two.
+void
+test01()
+{
+  VERIFY( queue(1).capacity() == 2 );
+  VERIFY( queue(3).capacity() == 4 );
+  VERIFY( queue(64).capacity() == 64 );
+}
+
+// Wrappers are invoked in the order they were pushed.
+void
+test02()
+{
+  queue q(8);
+  std::vector<int> order;
+  for (int i = 0; i < 8; ++i)
+    VERIFY( q.try_push([&order, i] { order.push_back(i); }) );
+  while (q.try_invoke())
+    ;
+  VERIFY( order == (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7}) );
+}
+
+// A push to a full queue fails and leaves its argument alone.
+void
+test03()
+{
+  queue q(4);
+  int calls = 0;
+  for (int i = 0; i < 4; ++i)
+    VERIFY( q.try_push([&calls] { ++calls; }) );
+
+  std::unique_function<void()> f([&calls] { calls += 10; });
+  VERIFY( !q.try_push(std::move(f)) );
+  VERIFY( f );
+  auto owner = std::make_unique<int>(1);
+  VERIFY( !q.try_push([p = std::move(owner)] { }) );
+
+  // Popping one makes room for one more.
+  VERIFY( q.try_invoke() );
+  VERIFY( q.try_push(std::move(f)) );
+  VERIFY( !q.try_push([] { }) );
+  while (q.try_invoke())
+    ;
+  VERIFY( calls == 14 );
+}
+
+// An empty queue has nothing to invoke or pop.
+void
+test04()
+{
+  queue q(4);
+  VERIFY( q.empty() );
+  VERIFY( !q.try_invoke() );
+  std::unique_function<void()> f([] { });
+  VERIFY( !q.try_pop(f) );
+  VERIFY( f );
+
+  VERIFY( q.try_push([] { }) );
+  VERIFY( !q.empty() );
+  VERIFY( q.try_pop(f) );
+  VERIFY( q.empty() );
+  VERIFY( !q.try_invoke() );
+}
+
+// Empty wrappers are pushed but skipped by the consumer.
+void
+test05()
+{
+  queue q(4);
+  int calls = 0;
+  VERIFY( q.try_push(nullptr) );
+  VERIFY( q.try_push([&calls] { ++calls; }) );
+  VERIFY( q.try_push(std::unique_function<void()>()) );
+  VERIFY( q.try_invoke() );
+  VERIFY( calls == 1 );
+  VERIFY( !q.try_invoke() );
+  VERIFY( q.empty() );
+}
+
+// A target whose move constructor throws inside try_push.
+void
+test06()
+{
+  queue q(4);
+  int calls = 0;
+  VERIFY( q.try_push([&calls] { ++calls; }) );
+
+  throwing_move::throw_on_move = true;
+  bool caught = false;
+  try
+    {
+      q.try_push(throwing_move());
+    }
+  catch (const std::runtime_error&)
+    {
+      caught = true;
+    }
+  throwing_move::throw_on_move = false;
+  VERIFY( caught );
+
+  // The claimed slot was published empty: the wrappers either side of it
+  // are still invoked in order, and it takes up room until the consumer
+  // passes it.
+  VERIFY( q.try_push([&calls] { calls += 10; }) );
+  VERIFY( q.try_push([&calls] { calls += 100; }) );
+  VERIFY( !q.try_push([] { }) );
+  VERIFY( q.try_invoke() );
+  VERIFY( calls == 1 );
+  VERIFY( q.try_invoke() );
+  VERIFY( calls == 11 );
+  VERIFY( q.try_push(throwing_move()) );
+  VERIFY( q.try_invoke() );
+  VERIFY( calls == 111 );
+  VERIFY( q.try_invoke() );
+  VERIFY( q.empty() );
+}
+
+// The destructor destroys the wrappers that were not popped.
+void
+test07()
+{
+  auto counter = std::make_shared<int>();
+  {
+    queue q(8);
+    for (int i = 0; i < 5; ++i)
+      VERIFY( q.try_push([counter] { }) );
+    VERIFY( q.try_invoke() );
+    VERIFY( counter.use_count() == 5 );
+  }
+  VERIFY( counter.use_count() == 1 );
+}
+
+// Each producer pushes its own increasing sequence through a queue much
+// smaller than the total, so producers contend for slots and find the
+// queue full; every sequence must arrive whole and in order.
+void
+test08()
+{
+  const int producers = 4;
+  const int per_producer = 20000;
+
+  std::unique_function_queue<void(std::vector<int>&)> q(64);
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p)
+    threads.emplace_back([&q, p] {
+      for (int i = 0; i < per_producer; ++i)
+	while (!q.try_push([p, i](std::vector<int>& next) {
+		 VERIFY( next[p] == i );
+		 next[p] = i + 1;
+	       }))
+	  std::this_thread::yield();
+    });
+
+  std::vector<int> next(producers, 0);
+  int popped = 0;
+  while (popped < producers * per_producer)
+    if (q.try_invoke(next))
+      ++popped;
+    else
+      std::this_thread::yield();
+
+  for (auto& t : threads)
+    t.join();
+  VERIFY( q.empty() );
+  VERIFY( next == std::vector<int>(producers, per_producer) );
+}
+
+// A one-shot task that gives up what it owns, so it may only be called
+// as an rvalue.
+struct one_shot
+{
+  void
+  operator()(std::unique_ptr<int>& out) &&
+  { out = std::move(owned); }
+
+  std::unique_ptr<int> owned;
+};
+
+// Wrappers with qualified signatures are invoked with those qualifiers.
+void
+test09()
+{
+  std::unique_function_queue<void(std::unique_ptr<int>&) &&> q(4);
+  VERIFY( q.try_push(one_shot{std::make_unique<int>(7)}) );
+  VERIFY( q.try_push(one_shot{std::make_unique<int>(8)}) );
+  std::unique_ptr<int> out;
+  VERIFY( q.try_invoke(out) );
+  VERIFY( out && *out == 7 );
+  VERIFY( q.try_invoke(out) );
+  VERIFY( out && *out == 8 );
+  VERIFY( !q.try_invoke(out) );
+
+  int calls = 0;
+  std::unique_function_queue<void() &> lq(4);
+  VERIFY( lq.try_push([&calls] { ++calls; }) );
+  std::unique_function_queue<void() const> cq(4);
+  VERIFY( cq.try_push([&calls] { calls += 10; }) );
+  std::unique_function_queue<void() const &&> crq(4);
+  VERIFY( crq.try_push([&calls] { calls += 100; }) );
+  VERIFY( lq.try_invoke() && cq.try_invoke() && crq.try_invoke() );
+  VERIFY( calls == 111 );
+}
+
+int
+main()
+{
+  test01();
+  test02();
+  test03();
+  test04();
+  test05();
+  test06();
+  test07();
+  test08();
+  test09();
+}
@@ -0,0 +1,153 @@
+// unique_function_reclaimer: targets are destroyed by drain(), by the
+// destructor or by the background thread, and on the calling thread when
+// the queue is full.
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "function_unique.h"
+#include "function_unique_reclaimer.h"
+#include "testsuite_hooks.h"
+
+using reclaimer = std::unique_function_reclaimer<>;
+
+const std::chrono::milliseconds no_thread(0);
+
+void
+free_function()
+{ }
+
+// drain() destroys the queued targets on the calling thread.
+void
+test01()
+{
+  reclaimer r(8, no_thread);
+  VERIFY( r.capacity() == 8 );
+  auto counter = std::make_shared<int>();
+  for (int i = 0; i < 3; ++i)
+    {
+      std::unique_function<void()> f([counter] { });
+      VERIFY( r.defer_destroy(std::move(f)) );
+      VERIFY( !f );
+    }
+  // Targets of other signatures share the queue.
+  std::unique_function<int(int) const> g([counter](int i) { return i; });
+  VERIFY( r.defer_destroy(std::move(g)) );
+  VERIFY( !g );
+
+  VERIFY( counter.use_count() == 5 );
+  VERIFY( r.drain() == 4 );
+  VERIFY( counter.use_count() == 1 );
+  VERIFY( r.drain() == 0 );
+}
+
+// Empty wrappers and targets without a destructor are not queued.
+void
+test02()
+{
+  reclaimer r(2, no_thread);
+  std::unique_function<void()> f;
+  VERIFY( r.defer_destroy(std::move(f)) );
+  f = &free_function;
+  VERIFY( r.defer_destroy(std::move(f)) );
+  VERIFY( !f );
+  VERIFY( r.drain() == 0 );
+}
+
+// When the queue is full the target is destroyed by defer_destroy itself,
+// and the queue is usable again once drained.
+void
+test03()
+{
+  reclaimer r(2, no_thread);
+  auto counter = std::make_shared<int>();
+  for (int i = 0; i < 2; ++i)
+    {
+      std::unique_function<void()> f([counter] { });
+      VERIFY( r.defer_destroy(std::move(f)) );
+    }
+  VERIFY( counter.use_count() == 3 );
+
+  std::unique_function<void()> f([counter] { });
+  VERIFY( counter.use_count() == 4 );
+  VERIFY( !r.defer_destroy(std::move(f)) );
+  VERIFY( !f );
+  VERIFY( counter.use_count() == 3 );
+
+  VERIFY( r.drain() == 2 );
+  f = [counter] { };
+  VERIFY( r.defer_destroy(std::move(f)) );
+  VERIFY( r.drain() == 1 );
+  VERIFY( counter.use_count() == 1 );
+}
+
+// The destructor destroys whatever is still queued, with or without a
+// background thread.
+void
+test04()
+{
+  auto counter = std::make_shared<int>();
+  {
+    reclaimer r(8, no_thread);
+    for (int i = 0; i < 5; ++i)
+      {
+	std::unique_function<void()> f([counter] { });
+	VERIFY( r.defer_destroy(std::move(f)) );
+      }
+    VERIFY( counter.use_count() == 6 );
+  }
+  VERIFY( counter.use_count() == 1 );
+
+  {
+    // An interval long enough that only the destructor drains.
+    reclaimer r(64, std::chrono::milliseconds(60000));
+    for (int i = 0; i < 5; ++i)
+      {
+	std::unique_function<void()> f([counter] { });
+	VERIFY( r.defer_destroy(std::move(f)) );
+      }
+  }
+  VERIFY( counter.use_count() == 1 );
+}
+
+// Several producers release targets while the background thread and
+// drain() empty the queue; every target is destroyed exactly once,
+// whether queued or destroyed by a producer that found the queue full.
+void
+test05()
+{
+  const int producers = 4;
+  const int per_producer = 10000;
+
+  auto counter = std::make_shared<int>();
+  {
+    reclaimer r(64, std::chrono::milliseconds(1));
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p)
+      threads.emplace_back([&r, counter] {
+	for (int i = 0; i < per_producer; ++i)
+	  {
+	    std::unique_function<void()> f([counter] { });
+	    r.defer_destroy(std::move(f));
+	    VERIFY( !f );
+	  }
+      });
+    for (int i = 0; i < 100; ++i)
+      r.drain();
+    for (auto& t : threads)
+      t.join();
+  }
+  VERIFY( counter.use_count() == 1 );
+}
+
+int
+main()
+{
+  test01();
+  test02();
+  test03();
+  test04();
+  test05();
+}
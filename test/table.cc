@@ -0,0 +1,325 @@
+// unique_function_table: stale handles, slot reuse, clear(), moves,
+// targets allocated from the slab, and callbacks that insert and erase
+// while they run.
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "function_unique.h"
+#include "function_unique_table.h"
+#include "testsuite_hooks.h"
+
+using table = std::unique_function_table<void(int&)>;
+using handle = table::handle;
+
+// Too large for the local buffer, so allocated from the slab.  Records
+// where it was stored.
+template<std::size_t _Bytes, std::size_t _Align = alignof(std::max_align_t)>
+  struct alignas(_Align) big
+  {
+    void
+    operator()(int& n)
+    {
+      VERIFY( reinterpret_cast<std::uintptr_t>(this) % _Align == 0 );
+      n += payload[0];
+      *where = this;
+    }
+
+    const void** where;
+    char payload[_Bytes] = { 1 };
+  };
+
+// A target whose constructor throws while throw_on_copy is set.
+struct throwing_copy
+{
+  static bool throw_on_copy;
+
+  throwing_copy() = default;
+
+  throwing_copy(const throwing_copy&)
+  {
+    if (throw_on_copy)
+      throw std::runtime_error("copy");
+  }
+
+  void operator()(int&) { }
+};
+
+bool throwing_copy::throw_on_copy = false;
+
+// Handles go stale on erase, and a reused slot gets a new generation.
+void
+test01()
+{
+  table t;
+  VERIFY( t.empty() );
+  VERIFY( !t.contains(handle()) );
+
+  int n = 0;
+  handle a = t.insert([](int& i) { i += 1; });
+  handle b = t.insert([](int& i) { i += 10; });
+  VERIFY( t.size() == 2 );
+  VERIFY( a != b );
+  VERIFY( t.invoke(a, n) && n == 1 );
+
+  VERIFY( t.erase(a) );
+  VERIFY( !t.contains(a) );
+  VERIFY( t.find(a) == nullptr );
+  VERIFY( !t.invoke(a, n) && n == 1 );
+  VERIFY( !t.erase(a) );
+  VERIFY( t.size() == 1 );
+
+  // The freed slot is reused, but the old handle does not reach the new
+  // callback.
+  handle c = t.insert([](int& i) { i += 100; });
+  VERIFY( c.index == a.index );
+  VERIFY( c.generation != a.generation );
+  VERIFY( !t.contains(a) );
+  VERIFY( !t.invoke(a, n) );
+  VERIFY( t.invoke(c, n) && n == 101 );
+  VERIFY( t.invoke(b, n) && n == 111 );
+
+  // A handle past the end is stale too.
+  VERIFY( !t.contains(handle(1000, 1)) );
+}
+
+// Freed slots are reused most recent first, before any new slot.
+void
+test02()
+{
+  table t;
+  std::vector<handle> hs;
+  for (int i = 0; i < 10; ++i)
+    hs.push_back(t.insert([](int&) { }));
+  VERIFY( t.erase(hs[3]) );
+  VERIFY( t.erase(hs[7]) );
+  VERIFY( t.insert([](int&) { }).index == hs[7].index );
+  VERIFY( t.insert([](int&) { }).index == hs[3].index );
+  VERIFY( t.insert([](int&) { }).index == 10 );
+  VERIFY( t.size() == 11 );
+}
+
+// clear() destroys every callback and makes every handle stale.
+void
+test03()
+{
+  auto counter = std::make_shared<int>();
+  table t;
+  std::vector<handle> hs;
+  for (int i = 0; i < 100; ++i)
+    hs.push_back(t.insert([counter](int&) { }));
+  VERIFY( counter.use_count() == 101 );
+  t.clear();
+  VERIFY( t.empty() );
+  VERIFY( counter.use_count() == 1 );
+  for (handle h : hs)
+    VERIFY( !t.contains(h) );
+
+  int n = 0;
+  handle h = t.insert([](int& i) { ++i; });
+  VERIFY( t.invoke(h, n) && n == 1 );
+  VERIFY( t.size() == 1 );
+}
+
+// A moved-from table is empty and usable; the new one keeps the handles.
+void
+test04()
+{
+  auto counter = std::make_shared<int>();
+  const void* where = nullptr;
+  table t;
+  std::vector<handle> hs;
+  for (int i = 0; i < 100; ++i)
+    hs.push_back(t.insert([counter](int& n) { ++n; }));
+  handle h_big = t.insert(big<64>{&where});
+
+  table u(std::move(t));
+  VERIFY( t.empty() );
+  VERIFY( u.size() == 101 );
+  for (handle h : hs)
+    VERIFY( !t.contains(h) && u.contains(h) );
+
+  // Inserting into the moved-from table starts from slot zero.
+  int n = 0;
+  handle h = t.insert([](int& i) { i += 1000; });
+  VERIFY( h.index == 0 );
+  VERIFY( t.invoke(h, n) && n == 1000 );
+  VERIFY( u.invoke(hs[50], n) && n == 1001 );
+  VERIFY( u.invoke(h_big, n) && n == 1002 );
+
+  // Assignment destroys what the target held.
+  t = std::move(u);
+  VERIFY( u.empty() );
+  VERIFY( counter.use_count() == 101 );
+  VERIFY( t.invoke(h_big, n) && n == 1003 );
+  handle g = u.insert([](int&) { });
+  VERIFY( u.contains(g) );
+
+  t = table();
+  VERIFY( counter.use_count() == 1 );
+}
+
+// Oversized and over-aligned targets come from the slab, which reuses
+// the block of an erased target for the next target of its size.
+void
+test05()
+{
+  table t;
+  const void* where = nullptr;
+  int n = 0;
+
+  handle a = t.insert(big<100>{&where});
+  VERIFY( t.invoke(a, n) && n == 1 );
+  const void* first = where;
+  handle b = t.insert(big<100>{&where});
+  VERIFY( t.invoke(b, n) && n == 2 );
+  VERIFY( where != first );
+
+  VERIFY( t.erase(a) );
+  handle c = t.insert(big<100>{&where});
+  VERIFY( t.invoke(c, n) && n == 3 );
+  VERIFY( where == first );
+
+  std::vector<handle> aligned;
+  for (int i = 0; i < 40; ++i)
+    aligned.push_back(t.insert(big<40, 64>{&where}));
+  for (handle h : aligned)
+    VERIFY( t.invoke(h, n) );
+  VERIFY( n == 43 );
+
+  // Larger than any size class.
+  handle d = t.insert(big<4096>{&where});
+  VERIFY( t.invoke(d, n) && n == 44 );
+}
+
+// A target whose constructor throws leaves the table as it was.
+void
+test06()
+{
+  table t;
+  handle a = t.insert([](int&) { });
+  throwing_copy f;
+  throwing_copy::throw_on_copy = true;
+  bool caught = false;
+  try
+    {
+      t.insert(f);
+    }
+  catch (const std::runtime_error&)
+    {
+      caught = true;
+    }
+  throwing_copy::throw_on_copy = false;
+  VERIFY( caught );
+  VERIFY( t.size() == 1 );
+  VERIFY( t.contains(a) );
+  handle b = t.insert(f);
+  VERIFY( b.index == 1 );
+  VERIFY( t.size() == 2 );
+}
+
+// A callback registers many more, forcing new slots while it runs, and a
+// pointer from find() stays valid.
+void
+test07()
+{
+  table t;
+  std::vector<handle> added;
+  int n = 0;
+  handle self = t.insert([&t, &added](int& i) {
+    for (int k = 0; k < 500; ++k)
+      added.push_back(t.insert([](int& j) { ++j; }));
+    ++i;
+  });
+  table::value_type* f = t.find(self);
+  VERIFY( t.invoke(self, n) && n == 1 );
+  VERIFY( t.size() == 501 );
+  VERIFY( t.find(self) == f );
+  for (handle h : added)
+    VERIFY( t.invoke(h, n) );
+  VERIFY( n == 501 );
+}
+
+// A callback erases itself, and is destroyed only once it returns.
+void
+test08()
+{
+  auto counter = std::make_shared<int>();
+  table t;
+  handle self;
+  int n = 0;
+  self = t.insert([&t, &self, counter](int& i) {
+    VERIFY( t.erase(self) );
+    VERIFY( !t.contains(self) );
+    VERIFY( !t.erase(self) );
+    // Still alive: its capture is intact.
+    VERIFY( counter.use_count() == 2 );
+    // The slot is not handed out while the callback runs.
+    handle h = t.insert([](int&) { });
+    VERIFY( h.index != self.index );
+    ++i;
+  });
+  VERIFY( t.invoke(self, n) && n == 1 );
+  VERIFY( counter.use_count() == 1 );
+  VERIFY( t.size() == 1 );
+  // The slot is free again.
+  VERIFY( t.insert([](int&) { }).index == self.index );
+}
+
+// Erasing from nested calls, and clear() from a callback, wait for the
+// outermost call; so does an exception leaving a callback.
+void
+test09()
+{
+  auto counter = std::make_shared<int>();
+  table t;
+  handle outer, inner;
+  int n = 0;
+  inner = t.insert([&t, &outer, &inner, counter](int& i) {
+    VERIFY( t.erase(outer) );
+    VERIFY( t.erase(inner) );
+    ++i;
+  });
+  outer = t.insert([&t, &inner, counter](int& i) {
+    VERIFY( t.invoke(inner, i) );
+    VERIFY( counter.use_count() == 3 );
+    ++i;
+  });
+  VERIFY( t.invoke(outer, n) && n == 2 );
+  VERIFY( t.empty() );
+  VERIFY( counter.use_count() == 1 );
+
+  handle h = t.insert([&t, counter](int&) {
+    t.clear();
+    VERIFY( counter.use_count() == 2 );
+    throw std::runtime_error("handler");
+  });
+  bool caught = false;
+  try
+    {
+      t.invoke(h, n);
+    }
+  catch (const std::runtime_error&)
+    {
+      caught = true;
+    }
+  VERIFY( caught );
+  VERIFY( t.empty() );
+  VERIFY( counter.use_count() == 1 );
+}
+
+int
+main()
+{
+  test01();
+  test02();
+  test03();
+  test04();
+  test05();
+  test06();
+  test07();
+  test08();
+  test09();
+}
@@ -0,0 +1,22 @@
+// Test support in the style of the libstdc++ testsuite.
+
+#ifndef FUNCTION_UNIQUE_TESTSUITE_HOOKS_H
+#define FUNCTION_UNIQUE_TESTSUITE_HOOKS_H
+
+#include <cstdio>
+#include <cstdlib>
+
+// Unlike assert, checked whatever NDEBUG says.
+#define VERIFY(fn)							\
+  do									\
+    {									\
+      if (!(fn))							\
+	{								\
+	  std::fprintf(stderr, "%s:%d: %s: Assertion '%s' failed.\n",	\
+		       __FILE__, __LINE__, __PRETTY_FUNCTION__, #fn);	\
+	  std::abort();							\
+	}								\
+    }									\
+  while (false)
+
+#endif
@@ -0,0 +1,172 @@
+// unique_function_thread_pool and its work-stealing deque: every task runs
+// exactly once, the destructor runs what is still pending, and a task's
+// exception reaches a future through std::packaged_task.
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "function_unique.h"
+#include "function_unique_thread_pool.h"
+#include "testsuite_hooks.h"
+
+using task = std::basic_unique_function<void(), 64>;
+
+// One owner pushes and pops through a deque much smaller than the total
+// while thieves steal from it, so slots are reused just after a thief has
+// released them; every task is taken exactly once.
+void
+test01()
+{
+  const int tasks = 50000;
+  const int thieves = 3;
+
+  std::_Work_stealing_deque<task> deque(8);
+  std::unique_ptr<std::atomic<int>[]> runs(new std::atomic<int>[tasks]);
+  for (int i = 0; i < tasks; ++i)
+    runs[i].store(0);
+  std::atomic<int> done(0);
+
+  auto run = [&done](task& t) {
+    t();
+    t = nullptr;
+    done.fetch_add(1);
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thieves; ++i)
+    threads.emplace_back([&] {
+      task stolen;
+      while (done.load() < tasks)
+	if (deque._M_steal(stolen))
+	  run(stolen);
+	else
+	  std::this_thread::yield();
+    });
+
+  task popped;
+  for (int i = 0; i < tasks; ++i)
+    {
+      auto count = [&runs, i] { runs[i].fetch_add(1); };
+      while (!deque._M_push(count))
+	if (deque._M_pop(popped))
+	  run(popped);
+      // Keep some of the work for the owner.
+      if (i % 3 == 0 && deque._M_pop(popped))
+	run(popped);
+    }
+  while (deque._M_pop(popped))
+    run(popped);
+
+  for (auto& t : threads)
+    t.join();
+  VERIFY( done.load() == tasks );
+  for (int i = 0; i < tasks; ++i)
+    VERIFY( runs[i].load() == 1 );
+}
+
+// A push to a full deque fails until a task is taken.
+void
+test02()
+{
+  std::_Work_stealing_deque<task> deque(4);
+  int calls = 0;
+  for (int i = 0; i < 4; ++i)
+    VERIFY( deque._M_push([&calls] { ++calls; }) );
+  VERIFY( !deque._M_push([] { }) );
+
+  task t;
+  VERIFY( deque._M_steal(t) );
+  t();
+  VERIFY( deque._M_push([&calls] { calls += 10; }) );
+  while (deque._M_pop(t))
+    t();
+  VERIFY( calls == 14 );
+  VERIFY( !deque._M_steal(t) );
+}
+
+// Tasks submitted from outside go through the shared queue; the tasks they
+// submit go onto the workers' own deques, which are small enough to
+// overflow back into the shared queue.  Every task runs exactly once.
+void
+test03()
+{
+  const int parents = 500;
+  const int children = 8;
+  const int tasks = parents * (children + 1);
+
+  std::unique_ptr<std::atomic<int>[]> runs(new std::atomic<int>[tasks]);
+  for (int i = 0; i < tasks; ++i)
+    runs[i].store(0);
+  {
+    std::unique_function_thread_pool<> pool(4, 4);
+    for (int p = 0; p < parents; ++p)
+      pool.submit([&pool, &runs, p] {
+	runs[p].fetch_add(1);
+	for (int c = 0; c < children; ++c)
+	  pool.submit([&runs, i = parents + p * children + c] {
+	    runs[i].fetch_add(1);
+	  });
+      });
+  }
+  for (int i = 0; i < tasks; ++i)
+    VERIFY( runs[i].load() == 1 );
+}
+
+// The destructor runs the tasks that are still pending.
+void
+test04()
+{
+  const int pending = 100;
+
+  std::promise<void> release;
+  std::atomic<int> runs(0);
+  {
+    std::unique_function_thread_pool<> pool(1);
+    // Hold the only worker until every other task has been submitted.
+    pool.submit([ready = release.get_future()]() mutable { ready.wait(); });
+    for (int i = 0; i < pending; ++i)
+      pool.submit([&runs] { runs.fetch_add(1); });
+    VERIFY( runs.load() == 0 );
+    release.set_value();
+  }
+  VERIFY( runs.load() == pending );
+}
+
+// A task that owns a std::packaged_task hands its exception to the future
+// rather than letting it escape.
+void
+test05()
+{
+  std::packaged_task<int()> work([]() -> int {
+    throw std::runtime_error("task");
+  });
+  std::future<int> result = work.get_future();
+  {
+    std::unique_function_thread_pool<> pool(2);
+    pool.submit(std::move(work));
+  }
+  bool caught = false;
+  try
+    {
+      result.get();
+    }
+  catch (const std::runtime_error&)
+    {
+      caught = true;
+    }
+  VERIFY( caught );
+}
+
+int
+main()
+{
+  test01();
+  test02();
+  test03();
+  test04();
+  test05();
+}
@@ -0,0 +1,21 @@
+// An exception that escapes a task of unique_function_thread_pool calls
+// std::terminate, as for the function of a std::thread.
+
+#include <cstdlib>
+#include <exception>
+#include <stdexcept>
+
+#include "function_unique.h"
+#include "function_unique_thread_pool.h"
+
+int
+main()
+{
+  std::set_terminate([] { std::_Exit(0); });
+  {
+    std::unique_function_thread_pool<> pool(2);
+    pool.submit([] { throw std::runtime_error("task"); });
+  }
+  // Not reached unless the exception was swallowed.
+  return 1;
+}